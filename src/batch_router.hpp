@@ -0,0 +1,61 @@
+#ifndef BATCH_ROUTER_HPP
+#define BATCH_ROUTER_HPP
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+#include "csr_graph.hpp"
+#include "search.hpp"
+#include "work_stealing_pool.hpp"
+
+struct RouteResult {
+    double distance = std::numeric_limits<double>::infinity();
+    std::vector<uint32_t> path; // Dense node indices, empty if unreachable
+};
+
+// Point-to-point Dijkstra scratch space over a CsrGraph: a Search that stops
+// once the target is settled and resets only the entries it touched, so one
+// instance can serve any number of queries without reallocating.
+class RouteWorkspace {
+    private:
+    Search<CsrGraph, double> m_Search;
+
+    public:
+    explicit RouteWorkspace(const CsrGraph& graph) : m_Search(graph) {}
+
+    void Route(uint32_t source, uint32_t target, RouteResult& result) {
+        result.distance = m_Search.Run(source, target);
+        result.path = m_Search.Path(target);
+    }
+};
+
+// Answers batches of (source, target) queries on every core. The graph is
+// shared read-only; each pool worker owns one RouteWorkspace.
+class BatchRouter {
+    private:
+    const CsrGraph& m_Graph;
+    WorkStealingPool m_Pool;
+    std::vector<std::unique_ptr<RouteWorkspace>> m_Workspaces;
+
+    public:
+    BatchRouter(const CsrGraph& graph, size_t threadCount)
+        : m_Graph(graph), m_Pool(threadCount)
+    {
+        for (size_t i = 0; i < m_Pool.Size(); i++) {
+            m_Workspaces.push_back(std::make_unique<RouteWorkspace>(m_Graph));
+        }
+    }
+
+    inline size_t Threads() const { return m_Pool.Size(); }
+
+    std::vector<RouteResult> Route(const std::vector<std::pair<uint32_t, uint32_t>>& queries, size_t grain = 16) {
+        std::vector<RouteResult> results(queries.size());
+        m_Pool.ParallelFor(queries.size(), grain, [&](size_t i, size_t worker){
+            m_Workspaces[worker]->Route(queries[i].first, queries[i].second, results[i]);
+        });
+        return results;
+    }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,220 @@
+#ifndef CONTRACTION_HIERARCHY_HPP
+#define CONTRACTION_HIERARCHY_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <queue>
+#include <tuple>
+#include <vector>
+#include "csr_graph.hpp"
+
+// Contraction hierarchy over a (directed) CsrGraph. Nodes are contracted in
+// lazily updated edge-difference order; a shortcut u->x is added for every
+// path u->v->x whose length no witness search can match.
+//
+// The result is stored in "sweep order": position 0 is the highest-ranked
+// node. Upward arcs go from a position to a smaller one; downward arcs are
+// grouped by their head, so a linear scan over positions can pull distances
+// down the hierarchy (PHAST) with purely sequential writes.
+class ContractionHierarchy {
+    private:
+    struct Arc { uint32_t node; double weight; };
+    static constexpr size_t WitnessSettleLimit = 500;
+
+    uint32_t m_NodeCount = 0;
+    size_t m_ShortcutCount = 0;
+    std::vector<uint32_t> m_Order;    // Position -> node
+    std::vector<uint32_t> m_Position; // Node -> position
+
+    std::vector<uint32_t> m_UpOffsets, m_UpHeads;
+    std::vector<double> m_UpWeights;
+    std::vector<uint32_t> m_DownOffsets, m_DownTails;
+    std::vector<double> m_DownWeights;
+
+    public:
+    explicit ContractionHierarchy(const CsrGraph& graph)
+        : m_NodeCount(graph.NodeCount())
+    {
+        build(graph);
+    }
+
+    inline uint32_t NodeCount() const { return m_NodeCount; }
+    inline size_t ShortcutCount() const { return m_ShortcutCount; }
+    inline uint32_t PositionOf(uint32_t node) const { return m_Position[node]; }
+    inline uint32_t NodeAt(uint32_t position) const { return m_Order[position]; }
+
+    // Arcs leaving position p towards higher-ranked nodes
+    inline uint32_t UpBegin(uint32_t p) const { return m_UpOffsets[p]; }
+    inline uint32_t UpEnd(uint32_t p) const { return m_UpOffsets[p + 1]; }
+    inline uint32_t UpHead(uint32_t a) const { return m_UpHeads[a]; }
+    inline double UpWeight(uint32_t a) const { return m_UpWeights[a]; }
+
+    // Arcs entering position p from higher-ranked nodes
+    inline uint32_t DownBegin(uint32_t p) const { return m_DownOffsets[p]; }
+    inline uint32_t DownEnd(uint32_t p) const { return m_DownOffsets[p + 1]; }
+    inline uint32_t DownTail(uint32_t a) const { return m_DownTails[a]; }
+    inline double DownWeight(uint32_t a) const { return m_DownWeights[a]; }
+
+    private:
+    struct Builder {
+        std::vector<std::vector<Arc>> out, in;
+        std::vector<uint8_t> contracted;
+        std::vector<int> deleted;
+
+        std::vector<double> dist;
+        std::vector<uint32_t> touched;
+    };
+
+    void build(const CsrGraph& graph) {
+        uint32_t n = m_NodeCount;
+        Builder b;
+        b.out.resize(n);
+        b.in.resize(n);
+        b.contracted.assign(n, 0);
+        b.deleted.assign(n, 0);
+        b.dist.assign(n, std::numeric_limits<double>::infinity());
+
+        std::vector<std::tuple<uint32_t, uint32_t, double>> edges;
+        for (uint32_t u = 0; u < n; u++) {
+            for (uint32_t e = graph.Begin(u); e < graph.End(u); e++) {
+                uint32_t v = graph.Target(e);
+                if (u == v) continue;
+                b.out[u].push_back({v, graph.Weight(e)});
+                b.in[v].push_back({u, graph.Weight(e)});
+                edges.emplace_back(u, v, graph.Weight(e));
+            }
+        }
+
+        using Entry = std::pair<int, uint32_t>;
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<>> pq;
+        std::vector<std::tuple<uint32_t, uint32_t, double>> shortcuts;
+        for (uint32_t v = 0; v < n; v++) {
+            pq.emplace(priority(b, v, shortcuts), v);
+        }
+
+        std::vector<uint32_t> rank(n);
+        uint32_t nextRank = 0;
+        while (!pq.empty()) {
+            uint32_t v = pq.top().second; pq.pop();
+            if (b.contracted[v]) continue;
+
+            // Lazy update: re-evaluate and defer if no longer the cheapest
+            int p = priority(b, v, shortcuts);
+            if (!pq.empty() && p > pq.top().first) {
+                pq.emplace(p, v);
+                continue;
+            }
+
+            for (const auto& [u, x, w]: shortcuts) {
+                b.out[u].push_back({x, w});
+                b.in[x].push_back({u, w});
+                edges.emplace_back(u, x, w);
+            }
+            m_ShortcutCount += shortcuts.size();
+
+            b.contracted[v] = 1;
+            rank[v] = nextRank++;
+            for (const auto& arc: b.out[v]) b.deleted[arc.node]++;
+            for (const auto& arc: b.in[v]) b.deleted[arc.node]++;
+        }
+
+        m_Order.resize(n);
+        m_Position.resize(n);
+        for (uint32_t v = 0; v < n; v++) {
+            m_Position[v] = n - 1 - rank[v];
+            m_Order[m_Position[v]] = v;
+        }
+
+        m_UpOffsets.assign(n + 1, 0);
+        m_DownOffsets.assign(n + 1, 0);
+        for (const auto& [u, x, w]: edges) {
+            if (rank[u] < rank[x]) m_UpOffsets[m_Position[u] + 1]++;
+            else m_DownOffsets[m_Position[x] + 1]++;
+        }
+        for (uint32_t p = 0; p < n; p++) {
+            m_UpOffsets[p + 1] += m_UpOffsets[p];
+            m_DownOffsets[p + 1] += m_DownOffsets[p];
+        }
+
+        m_UpHeads.resize(m_UpOffsets[n]);
+        m_UpWeights.resize(m_UpOffsets[n]);
+        m_DownTails.resize(m_DownOffsets[n]);
+        m_DownWeights.resize(m_DownOffsets[n]);
+        std::vector<uint32_t> upFill(m_UpOffsets.begin(), m_UpOffsets.end() - 1);
+        std::vector<uint32_t> downFill(m_DownOffsets.begin(), m_DownOffsets.end() - 1);
+        for (const auto& [u, x, w]: edges) {
+            if (rank[u] < rank[x]) {
+                uint32_t a = upFill[m_Position[u]]++;
+                m_UpHeads[a] = m_Position[x];
+                m_UpWeights[a] = w;
+            } else {
+                uint32_t a = downFill[m_Position[x]]++;
+                m_DownTails[a] = m_Position[u];
+                m_DownWeights[a] = w;
+            }
+        }
+    }
+
+    // Edge difference plus deleted neighbours; fills the shortcuts contracting v would need
+    int priority(Builder& b, uint32_t v, std::vector<std::tuple<uint32_t, uint32_t, double>>& shortcuts) {
+        shortcuts.clear();
+        int removed = 0;
+        double maxOut = 0;
+        for (const auto& arc: b.out[v]) {
+            if (b.contracted[arc.node]) continue;
+            removed++;
+            maxOut = std::max(maxOut, arc.weight);
+        }
+
+        for (const auto& [u, w1]: b.in[v]) {
+            if (b.contracted[u]) continue;
+            removed++;
+
+            witnessSearch(b, u, v, w1 + maxOut);
+            for (const auto& [x, w2]: b.out[v]) {
+                if (b.contracted[x] || x == u) continue;
+                if (b.dist[x] > w1 + w2) shortcuts.emplace_back(u, x, w1 + w2);
+            }
+            for (uint32_t t: b.touched) b.dist[t] = std::numeric_limits<double>::infinity();
+            b.touched.clear();
+        }
+
+        // Parallel arcs can produce the same shortcut twice; keep the shortest
+        std::sort(shortcuts.begin(), shortcuts.end());
+        shortcuts.erase(std::unique(shortcuts.begin(), shortcuts.end(), [](const auto& lhs, const auto& rhs){
+            return std::get<0>(lhs) == std::get<0>(rhs) && std::get<1>(lhs) == std::get<1>(rhs);
+        }), shortcuts.end());
+
+        return static_cast<int>(shortcuts.size()) - removed + b.deleted[v];
+    }
+
+    // Bounded Dijkstra from u over uncontracted nodes, skipping v
+    void witnessSearch(Builder& b, uint32_t u, uint32_t v, double maxDist) {
+        using Pair = std::pair<double, uint32_t>;
+        std::priority_queue<Pair, std::vector<Pair>, std::greater<>> pq;
+
+        b.dist[u] = 0;
+        b.touched.push_back(u);
+        pq.emplace(0, u);
+
+        size_t settled = 0;
+        while (!pq.empty() && settled++ < WitnessSettleLimit) {
+            auto [cost, x] = pq.top(); pq.pop();
+            if (cost > b.dist[x]) continue;
+            if (cost > maxDist) break;
+
+            for (const auto& arc: b.out[x]) {
+                if (arc.node == v || b.contracted[arc.node]) continue;
+                double alt = cost + arc.weight;
+                if (alt < b.dist[arc.node]) {
+                    if (b.dist[arc.node] == std::numeric_limits<double>::infinity()) b.touched.push_back(arc.node);
+                    b.dist[arc.node] = alt;
+                    pq.emplace(alt, arc.node);
+                }
+            }
+        }
+    }
+};
+
+#endif
\ No newline at end of file
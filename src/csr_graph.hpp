@@ -0,0 +1,179 @@
+#ifndef CSR_GRAPH_HPP
+#define CSR_GRAPH_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include "graph.hpp"
+
+// Edge weight storage, chosen when the CSR is built
+enum class WeightFormat {
+    Double,    // As loaded (metres)
+    Decimetres // uint32 fixed point: half the memory, exact integer sums
+};
+
+// Unreachable marker and fixed-point scale per weight type, so searches
+// templated on the weight type can use either representation
+template<typename W>
+struct WeightTraits {
+    static constexpr double FixedScale = 10.0; // Fixed-point units per metre
+
+    static constexpr W Infinity() {
+        if constexpr (std::numeric_limits<W>::has_infinity) return std::numeric_limits<W>::infinity();
+        else return std::numeric_limits<W>::max();
+    }
+
+    // Integer weights round up, so they never undercut the true length and
+    // a straight-line lower bound rounded down stays consistent with them
+    static W FromMetres(double metres) {
+        if constexpr (std::is_floating_point_v<W>) {
+            return static_cast<W>(metres);
+        } else {
+            double fixed = std::ceil(metres * FixedScale);
+            if (fixed >= static_cast<double>(Infinity())) {
+                throw std::runtime_error("Edge weight too large for fixed point\n");
+            }
+            return static_cast<W>(fixed);
+        }
+    }
+
+    static W LowerBoundFromMetres(double metres) {
+        if constexpr (std::is_floating_point_v<W>) return static_cast<W>(metres);
+        else return static_cast<W>(std::max(0.0, std::floor(metres * FixedScale)));
+    }
+
+    static double ToMetres(W weight) {
+        if constexpr (std::is_floating_point_v<W>) return weight;
+        else return weight / FixedScale;
+    }
+};
+
+// Immutable compressed-sparse-row view of a Graph. Nodes are renumbered to
+// dense indices [0, NodeCount()) and the out-edges of node v live in
+// [Begin(v), End(v)) of the target/weight arrays. Safe to share between
+// threads; search engines keep their own per-thread scratch arrays.
+//
+// Nodes keep the Graph's order (see NodeOrder) with contracted nodes left
+// out, so the engines built on top inherit its memory locality.
+class CsrGraph {
+    private:
+    static constexpr uint32_t NoNode = std::numeric_limits<uint32_t>::max();
+
+    std::vector<uint64_t> m_Ids;
+    std::vector<uint32_t> m_GraphIndex; // CSR index -> Graph index
+    std::vector<uint32_t> m_CsrIndex;   // Graph index -> CSR index (NoNode if contracted)
+    std::vector<uint32_t> m_Offsets;
+    std::vector<uint32_t> m_Targets;
+    WeightFormat m_Format;
+    std::vector<double> m_Weights;       // WeightFormat::Double
+    std::vector<uint32_t> m_FixedWeights; // WeightFormat::Decimetres
+    std::vector<double> m_Lat, m_Lon;
+    std::vector<float> m_X, m_Y; // Graph::X()/Y()
+    double m_HeuristicScale;
+
+    public:
+    static constexpr double FixedScale = WeightTraits<uint32_t>::FixedScale;
+
+    explicit CsrGraph(const Graph& graph, WeightFormat format = WeightFormat::Double)
+        : m_Format(format), m_HeuristicScale(graph.HeuristicScale())
+    {
+        const auto& G = graph.getGraph();
+
+        std::vector<uint32_t> nodes;
+        nodes.reserve(G.size());
+        for (uint32_t v = 0; v < G.size(); v++) {
+            if (!G[v].contracted) nodes.push_back(v);
+        }
+
+        m_CsrIndex.assign(G.size(), NoNode);
+        m_GraphIndex = nodes;
+        m_Ids.reserve(nodes.size());
+        m_Lat.reserve(nodes.size());
+        m_Lon.reserve(nodes.size());
+        for (uint32_t v = 0; v < nodes.size(); v++) {
+            const Node& node = G[nodes[v]];
+            m_CsrIndex[nodes[v]] = v;
+            m_Ids.push_back(graph.IdOf(nodes[v]));
+            m_Lat.push_back(node.lat);
+            m_Lon.push_back(node.lon);
+            m_X.push_back(graph.X()[nodes[v]]);
+            m_Y.push_back(graph.Y()[nodes[v]]);
+        }
+
+        m_Offsets.assign(nodes.size() + 1, 0);
+        for (uint32_t v = 0; v < nodes.size(); v++) {
+            const auto& neighbours = G[nodes[v]].neighbours;
+            m_Offsets[v + 1] = m_Offsets[v] + static_cast<uint32_t>(neighbours.size());
+
+            for (const auto& [to, weight]: neighbours) {
+                m_Targets.push_back(m_CsrIndex[to]);
+                if (format == WeightFormat::Double) {
+                    m_Weights.push_back(weight);
+                } else {
+                    m_FixedWeights.push_back(WeightTraits<uint32_t>::FromMetres(weight));
+                }
+            }
+        }
+    }
+
+    inline uint32_t NodeCount() const { return static_cast<uint32_t>(m_Ids.size()); }
+    inline uint32_t EdgeCount() const { return static_cast<uint32_t>(m_Targets.size()); }
+
+    inline uint32_t Begin(uint32_t v) const { return m_Offsets[v]; }
+    inline uint32_t End(uint32_t v) const { return m_Offsets[v + 1]; }
+    inline uint32_t Target(uint32_t e) const { return m_Targets[e]; }
+    inline WeightFormat Format() const { return m_Format; }
+
+    // Weight in metres, whatever the storage
+    inline double Weight(uint32_t e) const {
+        return m_Format == WeightFormat::Double ? m_Weights[e] : m_FixedWeights[e] / FixedScale;
+    }
+
+    // Weight as W: double gives metres, uint32_t the stored fixed-point
+    // units (only on a WeightFormat::Decimetres graph, see RequireWeights)
+    template<typename W>
+    inline W WeightAs(uint32_t e) const {
+        if constexpr (std::is_floating_point_v<W>) return static_cast<W>(Weight(e));
+        else return static_cast<W>(m_FixedWeights[e]);
+    }
+
+    // Searches on W call this once, so the relaxation loop never converts
+    template<typename W>
+    void RequireWeights() const {
+        if (std::is_integral_v<W> && m_Format != WeightFormat::Decimetres) {
+            throw std::runtime_error("Fixed-point weights need a WeightFormat::Decimetres graph\n");
+        }
+    }
+
+    inline double Lat(uint32_t v) const { return m_Lat[v]; }
+    inline double Lon(uint32_t v) const { return m_Lon[v]; }
+
+    // Planar coordinates copied from the Graph, in CSR order
+    inline const std::vector<float>& X() const { return m_X; }
+    inline const std::vector<float>& Y() const { return m_Y; }
+    inline double HeuristicScale() const { return m_HeuristicScale; }
+
+    // OSM id, and conversions to/from the Graph's own node indices
+    inline uint64_t IdOf(uint32_t v) const { return m_Ids[v]; }
+    inline uint32_t ToGraph(uint32_t v) const { return m_GraphIndex[v]; }
+    inline uint32_t GraphNodeCount() const { return static_cast<uint32_t>(m_CsrIndex.size()); }
+    uint32_t FromGraph(uint32_t graphIndex) const {
+        if (graphIndex >= m_CsrIndex.size() || m_CsrIndex[graphIndex] == NoNode) {
+            throw std::runtime_error("Node not found in graph\n");
+        }
+        return m_CsrIndex[graphIndex];
+    }
+
+    // Scatter a CSR-indexed array into Graph index order (infinity for contracted nodes)
+    std::vector<double> ToGraphOrder(const std::vector<double>& values) const {
+        std::vector<double> out(m_CsrIndex.size(), std::numeric_limits<double>::infinity());
+        for (uint32_t v = 0; v < values.size(); v++) out[m_GraphIndex[v]] = values[v];
+        return out;
+    }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,405 @@
+#ifndef CUSTOMIZABLE_CH_HPP
+#define CUSTOMIZABLE_CH_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "csr_graph.hpp"
+#include "partition.hpp"
+#include "work_stealing_pool.hpp"
+
+// Customizable contraction hierarchy (Dibbelt, Strasser, Wagner). The
+// preprocessing only looks at the topology: nodes are ranked by nested
+// dissection and contracted in that order without witness searches, so the
+// shortcuts are valid for any weights. A CchMetric then fills in the weights
+// for one weight array; it is cheap enough to rebuild whenever the weights
+// change (live traffic) and several metrics can share one CustomizableCH.
+// CchQuery answers point-to-point queries by walking the elimination tree.
+//
+// Every CCH edge joins a lower and a higher ranked node and is stored as an
+// arc at its lower end, with an upward (low -> high) and a downward
+// (high -> low) weight. The API takes CsrGraph node indices; internally
+// nodes are addressed by rank, 0 being the lowest.
+class CustomizableCH {
+    public:
+    static constexpr uint32_t NoNode = std::numeric_limits<uint32_t>::max();
+    static constexpr uint32_t NoArc = std::numeric_limits<uint32_t>::max();
+
+    private:
+    uint32_t m_NodeCount = 0;
+    std::vector<uint32_t> m_Rank;   // CSR node -> rank
+    std::vector<uint32_t> m_Order;  // Rank -> CSR node
+    std::vector<uint32_t> m_Parent; // Elimination tree: lowest upward neighbour
+
+    std::vector<uint32_t> m_ArcOffsets, m_ArcHeads, m_ArcTails;
+    // Lower triangles of each arc {low, high}: {w -> low, w -> high} arc pairs
+    std::vector<size_t> m_TriangleOffsets; // Can pass 2^32 on large graphs
+    std::vector<std::pair<uint32_t, uint32_t>> m_Triangles;
+    // Ranks grouped by elimination tree level; a level only depends on lower ones
+    std::vector<uint32_t> m_LevelOffsets, m_LevelNodes;
+
+    // Input CsrGraph edge -> arc and whether it runs upward
+    std::vector<uint32_t> m_EdgeArc;
+    std::vector<uint8_t> m_EdgeUpward;
+
+    public:
+    // The pool only speeds up the nested dissection; the order is the same without it
+    explicit CustomizableCH(const CsrGraph& graph, WorkStealingPool* pool = nullptr)
+        : m_NodeCount(graph.NodeCount())
+    {
+        UndirectedGraph undirected(graph);
+        m_Order = NestedDissectionOrder(undirected, 8, pool);
+        m_Rank.resize(m_NodeCount);
+        for (uint32_t r = 0; r < m_NodeCount; r++) m_Rank[m_Order[r]] = r;
+
+        contract(undirected);
+        buildTriangles();
+        buildLevels();
+        mapEdges(graph);
+    }
+
+    inline uint32_t NodeCount() const { return m_NodeCount; }
+    inline uint32_t ArcCount() const { return static_cast<uint32_t>(m_ArcHeads.size()); }
+    inline size_t TriangleCount() const { return m_Triangles.size(); }
+    inline uint32_t InputEdgeCount() const { return static_cast<uint32_t>(m_EdgeArc.size()); }
+
+    inline uint32_t RankOf(uint32_t node) const { return m_Rank[node]; }
+    inline uint32_t NodeAt(uint32_t rank) const { return m_Order[rank]; }
+    inline uint32_t Parent(uint32_t rank) const { return m_Parent[rank]; }
+
+    // Arcs from rank r to higher ranks, heads ascending
+    inline uint32_t ArcBegin(uint32_t r) const { return m_ArcOffsets[r]; }
+    inline uint32_t ArcEnd(uint32_t r) const { return m_ArcOffsets[r + 1]; }
+    inline uint32_t ArcHead(uint32_t a) const { return m_ArcHeads[a]; }
+    inline uint32_t ArcTail(uint32_t a) const { return m_ArcTails[a]; }
+
+    inline size_t TriangleBegin(uint32_t a) const { return m_TriangleOffsets[a]; }
+    inline size_t TriangleEnd(uint32_t a) const { return m_TriangleOffsets[a + 1]; }
+    inline const std::pair<uint32_t, uint32_t>& Triangle(size_t i) const { return m_Triangles[i]; }
+
+    inline uint32_t LevelCount() const { return static_cast<uint32_t>(m_LevelOffsets.size() - 1); }
+    inline uint32_t LevelBegin(uint32_t level) const { return m_LevelOffsets[level]; }
+    inline uint32_t LevelEnd(uint32_t level) const { return m_LevelOffsets[level + 1]; }
+    inline uint32_t LevelNode(uint32_t i) const { return m_LevelNodes[i]; }
+
+    inline uint32_t EdgeArc(uint32_t e) const { return m_EdgeArc[e]; }
+    inline bool EdgeUpward(uint32_t e) const { return m_EdgeUpward[e]; }
+
+    private:
+    // Eliminating a node makes its higher neighbours a clique. Adding them to
+    // its lowest higher neighbour (elimination tree parent) is enough, as that
+    // node passes them on when it is eliminated in turn.
+    void contract(const UndirectedGraph& graph) {
+        uint32_t n = m_NodeCount;
+        std::vector<std::vector<uint32_t>> up(n);
+        for (uint32_t v = 0; v < n; v++) {
+            for (uint32_t e = graph.Begin(v); e < graph.End(v); e++) {
+                uint32_t r = m_Rank[v], s = m_Rank[graph.Target(e)];
+                if (r < s) up[r].push_back(s);
+            }
+        }
+
+        m_Parent.assign(n, NoNode);
+        m_ArcOffsets.assign(n + 1, 0);
+        for (uint32_t r = 0; r < n; r++) {
+            auto& heads = up[r];
+            std::sort(heads.begin(), heads.end());
+            heads.erase(std::unique(heads.begin(), heads.end()), heads.end());
+            if (!heads.empty()) {
+                m_Parent[r] = heads[0];
+                auto& parent = up[heads[0]];
+                parent.insert(parent.end(), heads.begin() + 1, heads.end());
+            }
+
+            m_ArcOffsets[r + 1] = m_ArcOffsets[r] + static_cast<uint32_t>(heads.size());
+            m_ArcHeads.insert(m_ArcHeads.end(), heads.begin(), heads.end());
+            m_ArcTails.insert(m_ArcTails.end(), heads.size(), r);
+            std::vector<uint32_t>().swap(heads);
+        }
+    }
+
+    inline uint32_t findArc(uint32_t low, uint32_t high) const {
+        auto begin = m_ArcHeads.begin() + m_ArcOffsets[low], end = m_ArcHeads.begin() + m_ArcOffsets[low + 1];
+        auto it = std::lower_bound(begin, end, high);
+        return it != end && *it == high ? static_cast<uint32_t>(it - m_ArcHeads.begin()) : NoArc;
+    }
+
+    // Every pair of arcs leaving the same node w closes a triangle with the
+    // arc between their heads (which exists: contraction made them a clique)
+    template<typename Fn>
+    void forEachTriangle(Fn&& fn) const {
+        for (uint32_t w = 0; w < m_NodeCount; w++) {
+            for (uint32_t i = ArcBegin(w); i < ArcEnd(w); i++) {
+                for (uint32_t j = i + 1; j < ArcEnd(w); j++) {
+                    fn(findArc(m_ArcHeads[i], m_ArcHeads[j]), i, j);
+                }
+            }
+        }
+    }
+
+    void buildTriangles() {
+        m_TriangleOffsets.assign(ArcCount() + 1, 0);
+        forEachTriangle([&](uint32_t a, uint32_t, uint32_t){ m_TriangleOffsets[a + 1]++; });
+        for (uint32_t a = 0; a < ArcCount(); a++) m_TriangleOffsets[a + 1] += m_TriangleOffsets[a];
+
+        m_Triangles.resize(m_TriangleOffsets.back());
+        std::vector<size_t> fill(m_TriangleOffsets.begin(), m_TriangleOffsets.end() - 1);
+        forEachTriangle([&](uint32_t a, uint32_t lower, uint32_t upper){
+            m_Triangles[fill[a]++] = {lower, upper};
+        });
+    }
+
+    void buildLevels() {
+        std::vector<uint32_t> level(m_NodeCount, 0);
+        uint32_t levels = m_NodeCount ? 1 : 0;
+        for (uint32_t r = 0; r < m_NodeCount; r++) {
+            for (uint32_t a = ArcBegin(r); a < ArcEnd(r); a++) {
+                level[m_ArcHeads[a]] = std::max(level[m_ArcHeads[a]], level[r] + 1);
+            }
+            levels = std::max(levels, level[r] + 1);
+        }
+
+        m_LevelOffsets.assign(levels + 1, 0);
+        for (uint32_t r = 0; r < m_NodeCount; r++) m_LevelOffsets[level[r] + 1]++;
+        for (uint32_t l = 0; l < levels; l++) m_LevelOffsets[l + 1] += m_LevelOffsets[l];
+        m_LevelNodes.resize(m_NodeCount);
+        std::vector<uint32_t> fill(m_LevelOffsets.begin(), m_LevelOffsets.end() - 1);
+        for (uint32_t r = 0; r < m_NodeCount; r++) m_LevelNodes[fill[level[r]]++] = r;
+    }
+
+    void mapEdges(const CsrGraph& graph) {
+        m_EdgeArc.assign(graph.EdgeCount(), NoArc);
+        m_EdgeUpward.assign(graph.EdgeCount(), 0);
+        for (uint32_t u = 0; u < m_NodeCount; u++) {
+            for (uint32_t e = graph.Begin(u); e < graph.End(u); e++) {
+                uint32_t r = m_Rank[u], s = m_Rank[graph.Target(e)];
+                if (r == s) continue;
+                m_EdgeArc[e] = findArc(std::min(r, s), std::max(r, s));
+                m_EdgeUpward[e] = r < s;
+            }
+        }
+    }
+};
+
+
+// Arc weights of a CustomizableCH for one weight array. Customisation runs
+// level by level up the elimination tree: every arc takes the minimum over
+// its lower triangles, whose arcs all belong to lower levels and are final.
+// Arcs of one level are independent, so wide levels are split by node and
+// the long single-node chains near the top (separators) by arc. Immutable
+// once built: swap in a new metric to apply new weights while queries on
+// the old one finish.
+class CchMetric {
+    private:
+    static constexpr uint32_t ParallelNodes = 256, ParallelArcs = 64; // Less runs inline
+
+    const CustomizableCH& m_Cch;
+    std::vector<double> m_Up, m_Down;           // Customised
+    std::vector<double> m_InputUp, m_InputDown; // Input edges only, for unpacking
+
+    public:
+    // `weights` holds one value per edge of the CsrGraph the CCH was built on
+    CchMetric(const CustomizableCH& cch, const std::vector<double>& weights, WorkStealingPool* pool = nullptr)
+        : m_Cch(cch)
+    {
+        if (weights.size() != cch.InputEdgeCount()) {
+            throw std::runtime_error("Weight array does not match the graph\n");
+        }
+
+        const double inf = std::numeric_limits<double>::infinity();
+        m_InputUp.assign(cch.ArcCount(), inf);
+        m_InputDown.assign(cch.ArcCount(), inf);
+        for (uint32_t e = 0; e < weights.size(); e++) {
+            uint32_t a = cch.EdgeArc(e);
+            if (a == CustomizableCH::NoArc) continue;
+            double& slot = cch.EdgeUpward(e) ? m_InputUp[a] : m_InputDown[a];
+            slot = std::min(slot, weights[e]);
+        }
+        m_Up = m_InputUp;
+        m_Down = m_InputDown;
+
+        for (uint32_t level = 0; level < cch.LevelCount(); level++) {
+            uint32_t begin = cch.LevelBegin(level), count = cch.LevelEnd(level) - begin;
+            if (pool && count >= ParallelNodes) {
+                pool->ParallelFor(count, 64, [&](size_t i, size_t){ customizeNode(cch.LevelNode(begin + i)); });
+                continue;
+            }
+            for (uint32_t i = 0; i < count; i++) {
+                uint32_t r = cch.LevelNode(begin + i), first = cch.ArcBegin(r), arcs = cch.ArcEnd(r) - first;
+                if (pool && arcs >= ParallelArcs) {
+                    pool->ParallelFor(arcs, 8, [&](size_t a, size_t){ customizeArc(first + static_cast<uint32_t>(a)); });
+                } else {
+                    customizeNode(r);
+                }
+            }
+        }
+    }
+
+    // Metric for the graph's own weights
+    CchMetric(const CustomizableCH& cch, const CsrGraph& graph, WorkStealingPool* pool = nullptr)
+        : CchMetric(cch, edgeWeights(graph), pool) {}
+
+    inline const CustomizableCH& Cch() const { return m_Cch; }
+    inline double Up(uint32_t a) const { return m_Up[a]; }
+    inline double Down(uint32_t a) const { return m_Down[a]; }
+    inline double InputUp(uint32_t a) const { return m_InputUp[a]; }
+    inline double InputDown(uint32_t a) const { return m_InputDown[a]; }
+
+    private:
+    static std::vector<double> edgeWeights(const CsrGraph& graph) {
+        std::vector<double> weights(graph.EdgeCount());
+        for (uint32_t e = 0; e < graph.EdgeCount(); e++) weights[e] = graph.Weight(e);
+        return weights;
+    }
+
+    inline void customizeArc(uint32_t a) {
+        double up = m_Up[a], down = m_Down[a];
+        for (size_t t = m_Cch.TriangleBegin(a); t < m_Cch.TriangleEnd(a); t++) {
+            auto [lower, upper] = m_Cch.Triangle(t); // w -> low, w -> high
+            up = std::min(up, m_Down[lower] + m_Up[upper]);
+            down = std::min(down, m_Down[upper] + m_Up[lower]);
+        }
+        m_Up[a] = up;
+        m_Down[a] = down;
+    }
+
+    inline void customizeNode(uint32_t r) {
+        for (uint32_t a = m_Cch.ArcBegin(r); a < m_Cch.ArcEnd(r); a++) customizeArc(a);
+    }
+};
+
+
+// Point-to-point query: relax the upward arcs of every elimination tree
+// ancestor of the source (forward) and of the target (backward), in rank
+// order, then meet at the best common ancestor. No priority queue; the
+// search space is exactly the two ancestor chains. One per thread.
+class CchQuery {
+    private:
+    const CustomizableCH& m_Cch;
+    const CchMetric* m_Metric = nullptr;
+    std::vector<double> m_Forward, m_Backward;        // By rank
+    std::vector<uint32_t> m_ForwardArc, m_BackwardArc; // Arc each rank was reached by
+    uint32_t m_Source = CustomizableCH::NoNode, m_Target = CustomizableCH::NoNode;
+    uint32_t m_Meet = CustomizableCH::NoNode;
+
+    public:
+    explicit CchQuery(const CustomizableCH& cch)
+        : m_Cch(cch),
+          m_Forward(cch.NodeCount(), std::numeric_limits<double>::infinity()),
+          m_Backward(cch.NodeCount(), std::numeric_limits<double>::infinity()),
+          m_ForwardArc(cch.NodeCount(), CustomizableCH::NoArc),
+          m_BackwardArc(cch.NodeCount(), CustomizableCH::NoArc) {}
+
+    // CsrGraph node indices; infinity if the target cannot be reached
+    double Run(const CchMetric& metric, uint32_t source, uint32_t target) {
+        if (&metric.Cch() != &m_Cch) throw std::runtime_error("Metric belongs to another CCH\n");
+        if (source >= m_Cch.NodeCount() || target >= m_Cch.NodeCount()) {
+            throw std::runtime_error("Start or end node not found in graph\n");
+        }
+        reset();
+        m_Metric = &metric;
+        m_Source = m_Cch.RankOf(source);
+        m_Target = m_Cch.RankOf(target);
+
+        m_Forward[m_Source] = 0;
+        m_Backward[m_Target] = 0;
+        for (uint32_t r = m_Source; r != CustomizableCH::NoNode; r = m_Cch.Parent(r)) {
+            relax(r, m_Forward, m_ForwardArc, true);
+        }
+        for (uint32_t r = m_Target; r != CustomizableCH::NoNode; r = m_Cch.Parent(r)) {
+            relax(r, m_Backward, m_BackwardArc, false);
+        }
+
+        double best = std::numeric_limits<double>::infinity();
+        for (uint32_t r = m_Source; r != CustomizableCH::NoNode; r = m_Cch.Parent(r)) {
+            if (m_Forward[r] + m_Backward[r] < best) {
+                best = m_Forward[r] + m_Backward[r];
+                m_Meet = r;
+            }
+        }
+        return best;
+    }
+
+    // Path of the last Run() as CsrGraph node indices, shortcuts unpacked;
+    // empty if unreachable. The metric must still be alive.
+    std::vector<uint32_t> Path() const {
+        std::vector<uint32_t> path;
+        if (m_Meet == CustomizableCH::NoNode) return path;
+
+        // Hops as {arc, upward}: source up to the meeting node, then down to the target
+        std::vector<std::pair<uint32_t, bool>> hops;
+        for (uint32_t r = m_Meet; r != m_Source; r = m_Cch.ArcTail(m_ForwardArc[r])) hops.emplace_back(m_ForwardArc[r], true);
+        std::reverse(hops.begin(), hops.end());
+        for (uint32_t r = m_Meet; r != m_Target; r = m_Cch.ArcTail(m_BackwardArc[r])) hops.emplace_back(m_BackwardArc[r], false);
+
+        path.push_back(m_Cch.NodeAt(m_Source));
+        std::vector<std::pair<uint32_t, bool>> stack;
+        for (const auto& hop: hops) {
+            stack.push_back(hop);
+            while (!stack.empty()) {
+                auto [a, upward] = stack.back();
+                stack.pop_back();
+                unpack(a, upward, stack, path);
+            }
+        }
+        return path;
+    }
+
+    private:
+    // Forward chains use upward weights (low -> high); backward chains reach
+    // the target, so they use downward ones
+    inline void relax(uint32_t r, std::vector<double>& dist, std::vector<uint32_t>& via, bool forward) {
+        double d = dist[r];
+        if (d == std::numeric_limits<double>::infinity()) return;
+        for (uint32_t a = m_Cch.ArcBegin(r); a < m_Cch.ArcEnd(r); a++) {
+            uint32_t head = m_Cch.ArcHead(a);
+            double alt = d + (forward ? m_Metric->Up(a) : m_Metric->Down(a));
+            if (alt < dist[head]) {
+                dist[head] = alt;
+                via[head] = a;
+            }
+        }
+    }
+
+    // An arc either carries an input edge's weight, or that of one of its
+    // lower triangles exactly (customisation copied the sum)
+    void unpack(uint32_t a, bool upward, std::vector<std::pair<uint32_t, bool>>& stack, std::vector<uint32_t>& path) const {
+        const CchMetric& m = *m_Metric;
+        double weight = upward ? m.Up(a) : m.Down(a);
+        if (weight == (upward ? m.InputUp(a) : m.InputDown(a))) {
+            path.push_back(m_Cch.NodeAt(upward ? m_Cch.ArcHead(a) : m_Cch.ArcTail(a)));
+            return;
+        }
+        for (size_t t = m_Cch.TriangleBegin(a); t < m_Cch.TriangleEnd(a); t++) {
+            auto [lower, upper] = m_Cch.Triangle(t);
+            if (upward && m.Down(lower) + m.Up(upper) == weight) {
+                // low -> w -> high; the stack pops the first hop first
+                stack.emplace_back(upper, true);
+                stack.emplace_back(lower, false);
+                return;
+            }
+            if (!upward && m.Down(upper) + m.Up(lower) == weight) {
+                // high -> w -> low
+                stack.emplace_back(lower, true);
+                stack.emplace_back(upper, false);
+                return;
+            }
+        }
+        throw std::runtime_error("CCH shortcut could not be unpacked\n");
+    }
+
+    void reset() {
+        for (uint32_t start: {m_Source, m_Target}) {
+            for (uint32_t r = start; r != CustomizableCH::NoNode; r = m_Cch.Parent(r)) {
+                m_Forward[r] = m_Backward[r] = std::numeric_limits<double>::infinity();
+                m_ForwardArc[r] = m_BackwardArc[r] = CustomizableCH::NoArc;
+            }
+        }
+        m_Meet = CustomizableCH::NoNode;
+    }
+};
+
+#endif
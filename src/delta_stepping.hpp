@@ -0,0 +1,129 @@
+#ifndef DELTA_STEPPING_HPP
+#define DELTA_STEPPING_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "csr_graph.hpp"
+#include "work_stealing_pool.hpp"
+
+// Parallel one-to-all shortest distances (Meyer & Sanders delta-stepping).
+// Tentative distances are bucketed by floor(d / delta); each bucket is
+// emptied in phases that relax light edges (weight <= delta) of the current
+// frontier in parallel, then the heavy edges of everything it settled.
+// Distance updates are lock-free CAS-min; new bucket entries are collected
+// per worker and merged between phases. A delta of a few times the mean
+// edge length is a good start for road graphs.
+class DeltaStepping {
+    private:
+    const CsrGraph& m_Graph;
+    WorkStealingPool& m_Pool;
+    double m_Delta;
+
+    std::vector<std::atomic<double>> m_Dist;
+    std::vector<double> m_Result;
+    std::vector<std::vector<uint32_t>> m_Buckets;
+    std::vector<std::vector<uint32_t>> m_Local; // Per-worker improved nodes
+    std::vector<uint32_t> m_FrontierMark, m_SettledMark;
+    uint32_t m_Epoch = 0;
+
+    public:
+    DeltaStepping(const CsrGraph& graph, WorkStealingPool& pool, double delta)
+        : m_Graph(graph), m_Pool(pool), m_Delta(delta),
+          m_Dist(graph.NodeCount()), m_Local(pool.Size()),
+          m_FrontierMark(graph.NodeCount(), 0), m_SettledMark(graph.NodeCount(), 0)
+    {
+        if (!(m_Delta > 0)) {
+            throw std::runtime_error("Delta-stepping bucket width must be positive\n");
+        }
+    }
+
+    void Run(uint32_t source) {
+        for (auto& d: m_Dist) d.store(std::numeric_limits<double>::infinity(), std::memory_order_relaxed);
+        m_Buckets.assign(1, {source});
+        m_Dist[source].store(0, std::memory_order_relaxed);
+
+        std::vector<uint32_t> frontier, settled;
+        for (size_t i = 0; i < m_Buckets.size(); i++) {
+            uint32_t settledEpoch = nextEpoch();
+            settled.clear();
+
+            while (!m_Buckets[i].empty()) {
+                // Drop stale and duplicate entries; only nodes still in bucket i count
+                uint32_t frontierEpoch = nextEpoch();
+                frontier.clear();
+                for (uint32_t v: m_Buckets[i]) {
+                    if (bucketOf(m_Dist[v].load(std::memory_order_relaxed)) != i) continue;
+                    if (m_FrontierMark[v] == frontierEpoch) continue;
+                    m_FrontierMark[v] = frontierEpoch;
+                    frontier.push_back(v);
+                    if (m_SettledMark[v] != settledEpoch) {
+                        m_SettledMark[v] = settledEpoch;
+                        settled.push_back(v);
+                    }
+                }
+                m_Buckets[i].clear();
+
+                relax(frontier, true);
+            }
+            relax(settled, false);
+        }
+
+        m_Result.resize(m_Dist.size());
+        for (size_t v = 0; v < m_Dist.size(); v++) m_Result[v] = m_Dist[v].load(std::memory_order_relaxed);
+    }
+
+    inline double Delta() const { return m_Delta; }
+    inline const std::vector<double>& Distances() const { return m_Result; }
+
+    // Same shape as Pathfinder::GetDistances(): indexed by Graph node, infinity if unreachable
+    std::vector<double> GetDistances() const { return m_Graph.ToGraphOrder(m_Result); }
+
+    private:
+    inline size_t bucketOf(double d) const { return static_cast<size_t>(d / m_Delta); }
+
+    uint32_t nextEpoch() {
+        if (++m_Epoch == 0) {
+            std::fill(m_FrontierMark.begin(), m_FrontierMark.end(), 0);
+            std::fill(m_SettledMark.begin(), m_SettledMark.end(), 0);
+            m_Epoch = 1;
+        }
+        return m_Epoch;
+    }
+
+    void relax(const std::vector<uint32_t>& nodes, bool light) {
+        m_Pool.ParallelFor(nodes.size(), 64, [&](size_t k, size_t worker){
+            uint32_t u = nodes[k];
+            double du = m_Dist[u].load(std::memory_order_relaxed);
+
+            for (uint32_t e = m_Graph.Begin(u); e < m_Graph.End(u); e++) {
+                double weight = m_Graph.Weight(e);
+                if ((weight <= m_Delta) != light) continue;
+
+                uint32_t v = m_Graph.Target(e);
+                double alt = du + weight;
+                double old = m_Dist[v].load(std::memory_order_relaxed);
+                while (alt < old) {
+                    if (m_Dist[v].compare_exchange_weak(old, alt, std::memory_order_relaxed)) {
+                        m_Local[worker].push_back(v);
+                        break;
+                    }
+                }
+            }
+        });
+
+        // ParallelFor is a barrier, so the distances read here are final for this phase
+        for (auto& local: m_Local) {
+            for (uint32_t v: local) {
+                size_t b = bucketOf(m_Dist[v].load(std::memory_order_relaxed));
+                if (b >= m_Buckets.size()) m_Buckets.resize(b + 1);
+                m_Buckets[b].push_back(v);
+            }
+            local.clear();
+        }
+    }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,65 @@
+#ifndef DISTANCE_TABLE_HPP
+#define DISTANCE_TABLE_HPP
+
+#include <cstdint>
+#include <vector>
+#include "csr_graph.hpp"
+#include "search.hpp"
+
+// One-to-many and many-to-many shortest distances over a CsrGraph.
+// Each source runs a single Dijkstra (Search with a TargetsVisitor) that
+// stops as soon as every requested target is settled. Results are dense
+// row-major matrices with Unreachable (infinity, or the maximum for integer
+// weights) for unreachable pairs. One table per thread; the graph can be
+// shared.
+//
+// Weight is double (metres) or uint32_t (CsrGraph fixed-point units, exact
+// and identical on every platform; needs a WeightFormat::Decimetres graph).
+template<typename Weight>
+class BasicDistanceTable {
+    public:
+    static constexpr Weight Unreachable = WeightTraits<Weight>::Infinity();
+
+    private:
+    Search<CsrGraph, Weight, BinaryHeap, NoHeuristic, TargetsVisitor> m_Search;
+
+    public:
+    explicit BasicDistanceTable(const CsrGraph& graph)
+        : m_Search(graph, {}, TargetsVisitor(graph.NodeCount())) {}
+
+    std::vector<Weight> OneToMany(uint32_t source, const std::vector<uint32_t>& targets) {
+        std::vector<Weight> row(targets.size());
+        fillRow(source, targets, row.data());
+        return row;
+    }
+
+    // Row i holds the distances from sources[i]: result[i * targets.size() + j]
+    std::vector<Weight> ManyToMany(const std::vector<uint32_t>& sources, const std::vector<uint32_t>& targets) {
+        std::vector<Weight> matrix(sources.size() * targets.size());
+        ManyToMany(sources, targets, matrix.data());
+        return matrix;
+    }
+
+    // Same, into caller-owned storage of sources.size() * targets.size()
+    void ManyToMany(const std::vector<uint32_t>& sources, const std::vector<uint32_t>& targets, Weight* matrix) {
+        for (size_t i = 0; i < sources.size(); i++) {
+            fillRow(sources[i], targets, matrix + i * targets.size());
+        }
+    }
+
+    private:
+    void fillRow(uint32_t source, const std::vector<uint32_t>& targets, Weight* row) {
+        TargetsVisitor& visitor = m_Search.GetVisitor();
+        for (uint32_t t: targets) visitor.Add(t);
+        if (visitor.remaining > 0) m_Search.Run(source);
+        visitor.Clear(targets);
+
+        for (size_t j = 0; j < targets.size(); j++) {
+            row[j] = m_Search.Distance(targets[j]);
+        }
+    }
+};
+
+using DistanceTable = BasicDistanceTable<double>;
+
+#endif
\ No newline at end of file
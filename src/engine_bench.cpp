@@ -0,0 +1,355 @@
+#include "contraction_hierarchy.hpp"
+#include "customizable_ch.hpp"
+#include "graph_file.hpp"
+#include "overlay_graph.hpp"
+#include "search.hpp"
+#include "work_stealing_pool.hpp"
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <functional>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <thread>
+
+// Checks the preprocessed routing engines against plain Dijkstra
+// (Search<CsrGraph, double>) and reports their preprocessing and query
+// times, on the bundled graph and on a synthetic grid of roads. The
+// partition they share is compared with a plain median split. Every query
+// compares the distance and checks that the returned path is a real path of
+// that length; a new random metric is then customised and checked again.
+//
+//   ./engine_bench [graph.json] [grid_side] [threads] [queries]
+
+static double seconds(const std::function<void()>& call) {
+    auto start = std::chrono::steady_clock::now();
+    call();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static double haversine(double lat1, double lon1, double lat2, double lon2) {
+    constexpr double EarthRadius = 6371009.0, Rad = M_PI / 180.0;
+    double dLat = (lat2 - lat1) * Rad, dLon = (lon2 - lon1) * Rad;
+    double a = std::sin(dLat / 2) * std::sin(dLat / 2)
+             + std::cos(lat1 * Rad) * std::cos(lat2 * Rad) * std::sin(dLon / 2) * std::sin(dLon / 2);
+    return 2 * EarthRadius * std::asin(std::min(1.0, std::sqrt(a)));
+}
+
+// side x side intersections about 100 m apart with jitter; streets run both
+// ways except every seventh, which is one-way, and some blocks are missing
+static std::string writeGrid(uint32_t side) {
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<double> jitter(-0.0002, 0.0002), detour(1.0, 1.3), chance(0.0, 1.0);
+    GraphFile grid;
+    for (uint32_t r = 0; r < side; r++) {
+        for (uint32_t c = 0; c < side; c++) {
+            grid.ids.push_back(uint64_t(r) * side + c + 1);
+            grid.lat.push_back(23.0 + r * 0.0009 + jitter(rng));
+            grid.lon.push_back(77.0 + c * 0.00098 + jitter(rng));
+        }
+    }
+    auto street = [&](uint32_t a, uint32_t b, bool oneWay){
+        double length = haversine(grid.lat[a], grid.lon[a], grid.lat[b], grid.lon[b]) * detour(rng);
+        grid.from.push_back(a); grid.to.push_back(b); grid.weight.push_back(length);
+        if (oneWay) return;
+        grid.from.push_back(b); grid.to.push_back(a); grid.weight.push_back(length);
+    };
+    for (uint32_t r = 0; r < side; r++) {
+        for (uint32_t c = 0; c < side; c++) {
+            uint32_t v = r * side + c;
+            if (c + 1 < side && chance(rng) > 0.05) street(v, v + 1, r % 7 == 3);
+            if (r + 1 < side && chance(rng) > 0.05) street(v, v + side, c % 7 == 3);
+        }
+    }
+
+    std::string path = (std::filesystem::temp_directory_path() / "engine_bench_grid.bin").string();
+    WriteGraphFile(path, grid);
+    return path;
+}
+
+struct Workload {
+    const CsrGraph& graph;
+    std::vector<double> weights;                     // Per CSR edge
+    std::vector<std::pair<uint32_t, uint32_t>> pairs;
+    std::vector<double> expected;                    // Dijkstra distances
+    double dijkstraTime = 0;                         // Per query
+
+    Workload(const CsrGraph& csr, size_t queries) : graph(csr) {
+        std::mt19937 rng(5);
+        std::uniform_int_distribution<uint32_t> pick(0, csr.NodeCount() - 1);
+        for (size_t i = 0; i < queries; i++) pairs.emplace_back(pick(rng), pick(rng));
+        weights.resize(csr.EdgeCount());
+        for (uint32_t e = 0; e < csr.EdgeCount(); e++) weights[e] = csr.Weight(e);
+        solve(true);
+    }
+
+    // Random slowdowns on every edge, as a traffic update would bring
+    void Perturb() {
+        std::mt19937 rng(9);
+        std::uniform_real_distribution<double> factor(1.0, 3.0);
+        for (double& w: weights) w *= factor(rng);
+        solve(false);
+    }
+
+    // Distance matches and the path is a real path of that length
+    bool Check(size_t i, double distance, const std::vector<uint32_t>& path) const {
+        double want = expected[i];
+        if (std::isinf(want) || std::isinf(distance)) return std::isinf(want) && std::isinf(distance);
+        if (std::abs(distance - want) > 1e-6 * std::max(1.0, want)) return false;
+        if (path.empty() || path.front() != pairs[i].first || path.back() != pairs[i].second) return false;
+
+        double length = 0;
+        for (size_t j = 0; j + 1 < path.size(); j++) {
+            double best = std::numeric_limits<double>::infinity();
+            for (uint32_t e = graph.Begin(path[j]); e < graph.End(path[j]); e++) {
+                if (graph.Target(e) == path[j + 1]) best = std::min(best, weights[e]);
+            }
+            length += best;
+        }
+        return std::abs(length - want) <= 1e-6 * std::max(1.0, want);
+    }
+
+    private:
+    // Search<CsrGraph, double> for the graph's own weights, the same
+    // Dijkstra over the weight array once they are perturbed
+    void solve(bool own) {
+        expected.clear();
+        if (own) {
+            Search<CsrGraph, double> search(graph);
+            dijkstraTime = seconds([&]{
+                for (auto [s, t]: pairs) expected.push_back(search.Run(s, t));
+            }) / pairs.size();
+            return;
+        }
+
+        std::vector<double> dist(graph.NodeCount(), std::numeric_limits<double>::infinity());
+        std::vector<uint32_t> touched;
+        dijkstraTime = seconds([&]{
+            for (auto [s, t]: pairs) {
+                for (uint32_t v: touched) dist[v] = std::numeric_limits<double>::infinity();
+                touched.assign(1, s);
+                BinaryHeap<double> queue;
+                dist[s] = 0;
+                queue.Push(0, s);
+                while (!queue.Empty()) {
+                    auto [cost, u] = queue.Pop();
+                    if (cost > dist[u]) continue;
+                    if (u == t) break;
+                    for (uint32_t e = graph.Begin(u); e < graph.End(u); e++) {
+                        uint32_t v = graph.Target(e);
+                        if (cost + weights[e] >= dist[v]) continue;
+                        if (std::isinf(dist[v])) touched.push_back(v);
+                        dist[v] = cost + weights[e];
+                        queue.Push(dist[v], v);
+                    }
+                }
+                expected.push_back(dist[t]);
+            }
+        }) / pairs.size();
+    }
+};
+
+static void row(const std::string& label, const std::string& value) {
+    std::cout << "  " << std::left << std::setw(28) << label << value << std::endl;
+}
+
+static std::string ms(double s) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(s < 0.01 ? 3 : 1) << s * 1e3 << " ms";
+    return out.str();
+}
+
+static bool benchCch(Workload& work, WorkStealingPool& pool, bool classic) {
+    const CsrGraph& graph = work.graph;
+    std::unique_ptr<CustomizableCH> cch, pooled;
+    double sequential = seconds([&]{ cch = std::make_unique<CustomizableCH>(graph); });
+    double parallel = seconds([&]{ pooled = std::make_unique<CustomizableCH>(graph, &pool); });
+    row("preprocessing", ms(sequential) + " (" + ms(parallel) + " on the pool)");
+    row("arcs / triangles", std::to_string(cch->ArcCount()) + " / " + std::to_string(cch->TriangleCount()));
+
+    // The nested dissection order must not depend on the thread count
+    bool ok = cch->ArcCount() == pooled->ArcCount();
+    for (uint32_t r = 0; ok && r < cch->NodeCount(); r++) ok = cch->NodeAt(r) == pooled->NodeAt(r);
+    row("same order on the pool", ok ? "yes" : "NO");
+    pooled.reset();
+    if (classic) {
+        row("classic CH preprocessing", ms(seconds([&]{ ContractionHierarchy ch(graph); })));
+    }
+
+    for (int round = 0; round < 2; round++) {
+        if (round == 1) work.Perturb();
+        std::unique_ptr<CchMetric> metric;
+        sequential = seconds([&]{ CchMetric check(*cch, work.weights); });
+        parallel = seconds([&]{ metric = std::make_unique<CchMetric>(*cch, work.weights, &pool); });
+        row(round == 0 ? "customisation" : "re-customisation", ms(sequential) + " (" + ms(parallel) + " on the pool)");
+
+        CchQuery query(*cch);
+        size_t bad = 0;
+        double time = seconds([&]{
+            for (auto [s, t]: work.pairs) query.Run(*metric, s, t);
+        }) / work.pairs.size();
+        for (size_t i = 0; i < work.pairs.size(); i++) {
+            double distance = query.Run(*metric, work.pairs[i].first, work.pairs[i].second);
+            if (!work.Check(i, distance, query.Path())) bad++;
+        }
+        row("query", ms(time) + " (Dijkstra " + ms(work.dijkstraTime) + "), " + std::to_string(bad) + " mismatches");
+        ok = ok && bad == 0;
+    }
+    return ok;
+}
+
+static bool benchOverlay(Workload& work, WorkStealingPool& pool) {
+    const CsrGraph& graph = work.graph;
+    std::unique_ptr<OverlayGraph> overlay;
+    row("partition and overlay", ms(seconds([&]{ overlay = std::make_unique<OverlayGraph>(graph); })));
+    std::string cells;
+    for (uint32_t k = 0; k < overlay->LevelCount(); k++) {
+        cells += (k ? ", " : "") + std::to_string(overlay->CellCount(k)) + " / " + std::to_string(overlay->BoundaryCount(k));
+    }
+    row("cells / boundary by level", cells);
+
+    bool ok = true;
+    for (int round = 0; round < 2; round++) {
+        if (round == 1) work.Perturb();
+        std::unique_ptr<OverlayMetric> metric;
+        double sequential = seconds([&]{ OverlayMetric check(*overlay, work.weights); });
+        double parallel = seconds([&]{ metric = std::make_unique<OverlayMetric>(*overlay, work.weights, &pool); });
+        row(round == 0 ? "customisation" : "re-customisation", ms(sequential) + " (" + ms(parallel) + " on the pool)");
+
+        OverlayQuery query(*overlay);
+        size_t bad = 0, settled = 0;
+        double time = seconds([&]{
+            for (auto [s, t]: work.pairs) query.Run(*metric, s, t);
+        }) / work.pairs.size();
+        for (size_t i = 0; i < work.pairs.size(); i++) {
+            double distance = query.Run(*metric, work.pairs[i].first, work.pairs[i].second);
+            settled += query.Settled();
+            if (!work.Check(i, distance, query.Path())) bad++;
+        }
+        row("query", ms(time) + " (Dijkstra " + ms(work.dijkstraTime) + "), " + std::to_string(settled / work.pairs.size())
+            + " settled, " + std::to_string(bad) + " mismatches");
+        ok = ok && bad == 0;
+    }
+    return ok;
+}
+
+// Baseline for the partitioner: cells cut at the coordinate median along
+// whichever of the four directions cuts the fewest edges, no flow
+static MultiLevelPartition medianPartition(const UndirectedGraph& graph, const std::vector<uint32_t>& maxCellSizes) {
+    static const double directions[4][2] = {{1, 0}, {0, 1}, {1, 1}, {1, -1}};
+    uint32_t levels = static_cast<uint32_t>(maxCellSizes.size());
+    MultiLevelPartition partition;
+    partition.cell.assign(levels, std::vector<uint32_t>(graph.NodeCount(), 0));
+    partition.cellCount.assign(levels, 0);
+
+    std::vector<uint8_t> side(graph.NodeCount(), 2);
+    std::vector<std::pair<std::vector<uint32_t>, uint32_t>> stack(1);
+    for (uint32_t v = 0; v < graph.NodeCount(); v++) stack[0].first.push_back(v);
+    stack[0].second = levels - 1;
+    while (!stack.empty()) {
+        auto [nodes, level] = std::move(stack.back());
+        stack.pop_back();
+        if (nodes.size() <= maxCellSizes[level]) {
+            uint32_t id = partition.cellCount[level]++;
+            for (uint32_t v: nodes) partition.cell[level][v] = id;
+            if (level > 0) stack.emplace_back(std::move(nodes), level - 1);
+            continue;
+        }
+
+        std::vector<std::pair<double, uint32_t>> sorted(nodes.size());
+        std::vector<uint32_t> halves[2];
+        size_t half = nodes.size() / 2, bestCut = SIZE_MAX;
+        for (const auto& direction: directions) {
+            for (size_t i = 0; i < nodes.size(); i++) {
+                sorted[i] = {graph.X(nodes[i]) * direction[0] + graph.Y(nodes[i]) * direction[1], nodes[i]};
+            }
+            std::nth_element(sorted.begin(), sorted.begin() + half, sorted.end());
+            for (size_t i = 0; i < sorted.size(); i++) side[sorted[i].second] = i < half ? 0 : 1;
+            size_t cut = 0;
+            for (uint32_t v: nodes) {
+                for (uint32_t e = graph.Begin(v); e < graph.End(v); e++) {
+                    uint8_t other = side[graph.Target(e)];
+                    cut += other != 2 && other != side[v];
+                }
+            }
+            if (cut >= bestCut) continue;
+            bestCut = cut;
+            halves[0].clear();
+            halves[1].clear();
+            for (size_t i = 0; i < sorted.size(); i++) halves[i < half ? 0 : 1].push_back(sorted[i].second);
+        }
+        for (uint32_t v: nodes) side[v] = 2;
+        stack.emplace_back(std::move(halves[1]), level);
+        stack.emplace_back(std::move(halves[0]), level);
+    }
+    return partition;
+}
+
+static std::string quality(const UndirectedGraph& graph, const MultiLevelPartition& partition) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(2);
+    for (const PartitionQuality& level: EvaluatePartition(graph, partition)) {
+        if (out.tellp() > 0) out << ", ";
+        out << level.cells << " cells " << level.cutEdges << " cut " << level.imbalance << "x";
+    }
+    return out.str();
+}
+
+static bool benchPartition(const CsrGraph& csr, WorkStealingPool& pool) {
+    UndirectedGraph graph(csr);
+    std::vector<uint32_t> sizes = {128, 2048, 32768};
+    MultiLevelPartition flow, parallel, median;
+    double sequential = seconds([&]{ flow = RecursivePartition(graph, sizes); });
+    double pooled = seconds([&]{ parallel = RecursivePartition(graph, sizes, &pool); });
+    double baseline = seconds([&]{ median = medianPartition(graph, sizes); });
+    row("inertial flow", ms(sequential) + " (" + ms(pooled) + " on the pool)");
+    row("  by level", quality(graph, flow));
+    row("median split", ms(baseline));
+    row("  by level", quality(graph, median));
+
+    // Same cells for any thread count, and every cell inside one cell of the level above
+    bool ok = flow.cell == parallel.cell && flow.cellCount == parallel.cellCount;
+    for (uint32_t k = 0; k + 1 < flow.LevelCount(); k++) {
+        std::vector<uint32_t> parent(flow.cellCount[k], std::numeric_limits<uint32_t>::max());
+        for (uint32_t v = 0; v < graph.NodeCount(); v++) {
+            uint32_t& up = parent[flow.cell[k][v]];
+            if (up == std::numeric_limits<uint32_t>::max()) up = flow.cell[k + 1][v];
+            ok = ok && up == flow.cell[k + 1][v];
+        }
+    }
+    row("deterministic and nested", ok ? "yes" : "NO");
+    return ok;
+}
+
+int main(int argc, char** argv){
+    std::string graphPath = argc > 1 ? argv[1] : "./maps/map_graph.json";
+    uint32_t gridSide = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 150;
+    size_t threads = argc > 3 ? std::stoul(argv[3]) : std::thread::hardware_concurrency();
+    size_t queries = argc > 4 ? std::stoul(argv[4]) : 1000;
+
+    WorkStealingPool pool(threads);
+    std::vector<std::pair<std::string, std::string>> inputs = {{"graph", graphPath}};
+    if (gridSide > 1) inputs.emplace_back("grid", writeGrid(gridSide));
+
+    bool ok = true;
+    for (const auto& [name, path]: inputs) {
+        Graph graph(path);
+        CsrGraph csr(graph);
+        std::cout << name << " (" << csr.NodeCount() << " nodes, " << csr.EdgeCount() << " edges, "
+                  << queries << " queries)" << std::endl;
+
+        std::cout << " partition (cells of 128 / 2048 / 32768 nodes)" << std::endl;
+        ok = benchPartition(csr, pool) && ok;
+
+        std::cout << " customizable CH" << std::endl;
+        Workload cchWork(csr, queries);
+        ok = benchCch(cchWork, pool, true) && ok;
+
+        std::cout << " overlay graph" << std::endl;
+        Workload overlayWork(csr, queries);
+        ok = benchOverlay(overlayWork, pool) && ok;
+    }
+    std::cout << (ok ? "All engines agree with Dijkstra" : "MISMATCH") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,95 @@
+#ifndef FLAT_ID_MAP_HPP
+#define FLAT_ID_MAP_HPP
+
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Open-addressing hash map from 64-bit OSM ids to dense node indices.
+// Keys and values sit side by side in one flat array with linear probing,
+// so a lookup is a hash and usually a single cache line. Load factor is
+// kept at or below 1/2. The all-ones id is reserved as the empty marker.
+class FlatIdMap {
+    private:
+    static constexpr uint64_t Empty = std::numeric_limits<uint64_t>::max();
+
+    struct Slot {
+        uint64_t key = Empty;
+        uint32_t value = 0;
+    };
+
+    std::vector<Slot> m_Slots;
+    size_t m_Size = 0;
+    size_t m_Mask = 0;
+
+    public:
+    FlatIdMap() { rehash(16); }
+
+    void Reserve(size_t count) {
+        size_t capacity = 16;
+        while (capacity < count * 2) capacity <<= 1;
+        if (capacity > m_Slots.size()) rehash(capacity);
+    }
+
+    // Inserts or overwrites
+    void Insert(uint64_t key, uint32_t value) {
+        if (key == Empty) {
+            throw std::runtime_error("Node id " + std::to_string(key) + " is reserved\n");
+        }
+        if ((m_Size + 1) * 2 > m_Slots.size()) rehash(m_Slots.size() * 2);
+
+        size_t i = slotFor(key);
+        if (m_Slots[i].key == Empty) {
+            m_Slots[i].key = key;
+            m_Size++;
+        }
+        m_Slots[i].value = value;
+    }
+
+    bool Find(uint64_t key, uint32_t& value) const {
+        const Slot& slot = m_Slots[slotFor(key)];
+        if (slot.key != key) return false;
+        value = slot.value;
+        return true;
+    }
+
+    inline bool Contains(uint64_t key) const { return m_Slots[slotFor(key)].key == key; }
+
+    uint32_t At(uint64_t key) const {
+        uint32_t value;
+        if (!Find(key, value)) {
+            throw std::runtime_error("Node " + std::to_string(key) + " not found in graph\n");
+        }
+        return value;
+    }
+
+    inline size_t Size() const { return m_Size; }
+
+    private:
+    static inline uint64_t mix(uint64_t x) {
+        x ^= x >> 30; x *= 0xBF58476D1CE4E5B9ull;
+        x ^= x >> 27; x *= 0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+    }
+
+    // Slot holding key, or the empty slot where it would go
+    inline size_t slotFor(uint64_t key) const {
+        size_t i = mix(key) & m_Mask;
+        while (m_Slots[i].key != key && m_Slots[i].key != Empty) i = (i + 1) & m_Mask;
+        return i;
+    }
+
+    void rehash(size_t capacity) {
+        std::vector<Slot> old = std::move(m_Slots);
+        m_Slots.assign(capacity, Slot{});
+        m_Mask = capacity - 1;
+        m_Size = 0;
+        for (const Slot& slot: old) {
+            if (slot.key != Empty) Insert(slot.key, slot.value);
+        }
+    }
+};
+
+#endif
\ No newline at end of file
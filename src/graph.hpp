@@ -1,26 +1,266 @@
 #ifndef GRAPH_HPP
 #define GRAPH_HPP
 
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
+#include <limits>
+#include <numeric>
 #include <vector>
 #include <unordered_map>
 #include <nlohmann/json.hpp>
+#include "flat_id_map.hpp"
+#include "graph_file.hpp"
+#include "simd_kernels.hpp"
 
-using json = nlohmann::json; 
+using json = nlohmann::json;
 
 struct Node {
     double lat, lon;
-    std::vector<std::pair<std::string, double>> neighbours; // (Neighbor ID, weight)
+    std::vector<std::pair<uint32_t, double>> neighbours; // (Neighbour index, weight)
+    uint32_t component = 0;       // Weakly connected component
+    uint32_t strongComponent = 0; // Strongly connected component
+    bool contracted = false;      // Folded into an edge by ContractChains()
 };
 
 
+// Local equirectangular projection about the centre of the graph: x metres
+// east, y metres north. Linear in lat/lon, so map pixels are one scale and
+// offset per axis away, and float32 keeps sub-metre precision across a
+// region.
+struct PlanarProjection {
+    double lat0 = 0, lon0 = 0;
+    double metresPerLat = 0, metresPerLon = 0;
+
+    PlanarProjection() = default;
+    PlanarProjection(double centreLat, double centreLon)
+        : lat0(centreLat), lon0(centreLon),
+          metresPerLat(6371009.0 * M_PI / 180.0),
+          metresPerLon(metresPerLat * std::cos(centreLat * M_PI / 180.0)) {}
+
+    inline float X(double lon) const { return static_cast<float>((lon - lon0) * metresPerLon); }
+    inline float Y(double lat) const { return static_cast<float>((lat - lat0) * metresPerLat); }
+
+    // Largest k <= 1 such that k times the planar distance never exceeds the
+    // great-circle distance between points with latitudes in [latMin,
+    // latMax]: east-west scale is exact at lat0 and shrinks away from it
+    inline double LowerBoundScale(double latMin, double latMax) const {
+        double farthest = std::max(std::abs(latMin), std::abs(latMax));
+        return std::min(1.0, std::cos(farthest * M_PI / 180.0) / std::cos(lat0 * M_PI / 180.0));
+    }
+};
+
+
+enum class NodeOrder {
+    Input,   // File order
+    Hilbert, // Along a Hilbert curve over the node coordinates
+    Bfs      // Breadth-first over the road network
+};
+
+
+// Nodes live in a dense array; OSM ids are parsed to integers at load and
+// mapped to indices through a flat hash map. Everything downstream works
+// on indices and only turns them back into ids (IdOf) for output.
+//
+// By default nodes are numbered along a Hilbert curve, so intersections
+// close on the map are close in memory and searches, snapping and drawing
+// touch few cache lines. Adjacency lists are sorted by target index.
 class Graph {
     private:
-    std::unordered_map<std::string, Node> m_Graph;
+    std::vector<Node> m_Nodes;
+    std::vector<uint64_t> m_Ids;
+    FlatIdMap m_Index;
+    uint32_t m_LargestStrongComponent = 0;
+
+    // Projected coordinates, structure-of-arrays for scans over all nodes
+    PlanarProjection m_Projection;
+    std::vector<float> m_X, m_Y;
+    double m_HeuristicScale = 1;
+
+    // Packed coordinates of the nodes NearestNode may return, so the scan
+    // is one branch-free SIMD pass (all snap targets / largest SCC only)
+    struct SnapTargets {
+        std::vector<float> x, y;
+        std::vector<uint32_t> node;
+    };
+    SnapTargets m_Snap, m_SnapLargest;
+
+    // Interior nodes of each contracted edge in travel order, with their
+    // distance from the edge's start, keyed by (from << 32 | to)
+    std::unordered_map<uint64_t, std::vector<std::pair<uint32_t, double>>> m_Via;
 
     public:
-    Graph(const std::string& filePath){
+    // Edges are kept directed as exported (osmnx already lists both directions
+    // of two-way streets), parallel edges collapse to the lightest one and
+    // self-loops are dropped. dropIsolated also removes nodes with no edges.
+    // Accepts either the JSON export of map_loader.py or a binary graph
+    // written by osm_import (see graph_file.hpp).
+    Graph(const std::string& filePath, bool dropIsolated = false, NodeOrder order = NodeOrder::Hilbert){
+        if (IsGraphFile(filePath)) loadBinary(filePath);
+        else loadJson(filePath);
+
+        normalise(dropIsolated);
+        if (order == NodeOrder::Hilbert) renumber(hilbertOrder());
+        else if (order == NodeOrder::Bfs) renumber(bfsOrder());
+        project();
+        computeComponents();
+        collectSnapTargets();
+    }
+
+    inline const std::vector<Node>& getGraph() const { return m_Nodes; }
+    inline uint32_t NodeCount() const { return static_cast<uint32_t>(m_Nodes.size()); }
+
+    // OSM id <-> dense index
+    inline uint64_t IdOf(uint32_t v) const { return m_Ids[v]; }
+    inline uint32_t IndexOf(uint64_t id) const { return m_Index.At(id); }
+
+    // Planar x/y of every node in metres (see PlanarProjection), by index
+    inline const PlanarProjection& Projection() const { return m_Projection; }
+    inline const std::vector<float>& X() const { return m_X; }
+    inline const std::vector<float>& Y() const { return m_Y; }
+    // Factor keeping planar distances a lower bound on edge lengths (A*)
+    inline double HeuristicScale() const { return m_HeuristicScale; }
+
+    // Fold degree-2 nodes (a<->v<->b, or a->v->b on oneway roads) into single
+    // edges carrying the summed weight; the folded nodes become the edge's
+    // geometry. Skipped where it would duplicate an existing edge or close a
+    // loop. Folded nodes keep their index and coordinates but lose their
+    // edges and are no longer snap targets. Returns how many were folded;
+    // use ExpandPath() to restore full node sequences and Via() to walk an
+    // edge's geometry.
+    size_t ContractChains() {
+        std::vector<std::vector<std::pair<uint32_t, double>>> incoming(m_Nodes.size());
+        for (uint32_t u = 0; u < m_Nodes.size(); u++) {
+            for (const auto& [to, weight]: m_Nodes[u].neighbours) incoming[to].emplace_back(u, weight);
+        }
+
+        auto weightOf = [](const std::vector<std::pair<uint32_t, double>>& arcs, uint32_t id) {
+            for (const auto& [other, weight]: arcs) if (other == id) return weight;
+            return -1.0;
+        };
+        auto removeArc = [](std::vector<std::pair<uint32_t, double>>& arcs, uint32_t id) {
+            arcs.erase(std::remove_if(arcs.begin(), arcs.end(), [&](const auto& arc){ return arc.first == id; }), arcs.end());
+        };
+        // a -> v -> b becomes a -> b; v lies `first` along it
+        auto fold = [&](uint32_t a, uint32_t v, uint32_t b, double first, double weight) {
+            std::vector<std::pair<uint32_t, double>> via;
+            if (auto it = m_Via.find(viaKey(a, v)); it != m_Via.end()) via = std::move(it->second);
+            via.emplace_back(v, first);
+            if (auto it = m_Via.find(viaKey(v, b)); it != m_Via.end()) {
+                for (const auto& [node, offset]: it->second) via.emplace_back(node, first + offset);
+            }
+
+            auto& arcs = m_Nodes[a].neighbours;
+            removeArc(arcs, v);
+            removeArc(incoming[b], v);
+            arcs.insert(std::lower_bound(arcs.begin(), arcs.end(), std::make_pair(b, weight)), {b, weight});
+            incoming[b].emplace_back(a, weight);
+            m_Via.erase(viaKey(a, v));
+            m_Via[viaKey(a, b)] = std::move(via);
+        };
+
+        size_t removed = 0;
+        for (uint32_t v = 0; v < m_Nodes.size(); v++) {
+            const auto& out = m_Nodes[v].neighbours;
+            const auto& in = incoming[v];
+
+            if (out.size() == 2 && in.size() == 2) {
+                uint32_t a = out[0].first, b = out[1].first;
+                if (weightOf(in, a) < 0 || weightOf(in, b) < 0) continue;
+                if (weightOf(m_Nodes[a].neighbours, b) >= 0 || weightOf(m_Nodes[b].neighbours, a) >= 0) continue;
+
+                double av = weightOf(in, a), bv = weightOf(in, b);
+                fold(a, v, b, av, av + weightOf(out, b));
+                fold(b, v, a, bv, bv + weightOf(out, a));
+                m_Via.erase(viaKey(v, a));
+                m_Via.erase(viaKey(v, b));
+            } else if (out.size() == 1 && in.size() == 1) {
+                uint32_t a = in[0].first, b = out[0].first;
+                if (a == b || weightOf(m_Nodes[a].neighbours, b) >= 0) continue;
+
+                fold(a, v, b, in[0].second, in[0].second + out[0].second);
+                m_Via.erase(viaKey(v, b));
+            } else {
+                continue;
+            }
+
+            incoming[v].clear();
+            m_Nodes[v].neighbours.clear();
+            m_Nodes[v].contracted = true;
+            removed++;
+        }
+        collectSnapTargets();
+        return removed;
+    }
+
+    // Re-insert the folded nodes between consecutive nodes of a path
+    std::vector<uint32_t> ExpandPath(const std::vector<uint32_t>& path) const {
+        std::vector<uint32_t> full;
+        for (size_t i = 0; i < path.size(); i++) {
+            if (i > 0) {
+                auto via = m_Via.find(viaKey(path[i - 1], path[i]));
+                if (via != m_Via.end()) {
+                    for (const auto& [node, _]: via->second) full.push_back(node);
+                }
+            }
+            full.push_back(path[i]);
+        }
+        return full;
+    }
+
+    // Folded nodes of edge from -> to with their distance from `from`, in
+    // travel order; nullptr if the edge was not contracted
+    const std::vector<std::pair<uint32_t, double>>* Via(uint32_t from, uint32_t to) const {
+        auto via = m_Via.find(viaKey(from, to));
+        return via == m_Via.end() ? nullptr : &via->second;
+    }
+
+    // O(1) rejection: false means no path can exist between the two nodes.
+    // True is only a guarantee within the same strong component.
+    inline bool Connected(uint32_t from, uint32_t to) const {
+        return m_Nodes[from].component == m_Nodes[to].component;
+    }
+
+    inline bool StronglyConnected(uint32_t from, uint32_t to) const {
+        return m_Nodes[from].strongComponent == m_Nodes[to].strongComponent;
+    }
+
+    // Snap a coordinate to the closest node (planar distance). With
+    // largestComponentOnly, candidates are limited to the largest strong
+    // component, so any two snapped points are mutually reachable.
+    uint32_t NearestNode(double lat, double lon, bool largestComponentOnly = false) const {
+        const SnapTargets& targets = largestComponentOnly ? m_SnapLargest : m_Snap;
+        if (targets.node.empty()) {
+            throw std::runtime_error("Graph has no nodes to snap to\n");
+        }
+
+        uint32_t i = simd::Nearest(targets.x.data(), targets.y.data(), static_cast<uint32_t>(targets.node.size()),
+                                   m_Projection.X(lon), m_Projection.Y(lat));
+        return targets.node[i];
+    }
+
+    private:
+    static inline uint64_t viaKey(uint32_t from, uint32_t to) {
+        return static_cast<uint64_t>(from) << 32 | to;
+    }
+
+    static uint64_t parseId(const std::string& text) {
+        uint64_t id = 0;
+        auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), id);
+        if (error != std::errc() || end != text.data() + text.size()) {
+            throw std::runtime_error("Invalid node id '" + text + "'\n");
+        }
+        return id;
+    }
+
+    static uint64_t parseId(const json& value) {
+        return value.is_string() ? parseId(value.get<std::string>()) : value.get<uint64_t>();
+    }
+
+    void loadJson(const std::string& filePath) {
         std::ifstream f(filePath);
         if (!f.is_open()) {
             throw std::runtime_error("Failed to open the file\n");
@@ -28,22 +268,266 @@ class Graph {
 
         json data; f >> data;
 
+        m_Nodes.reserve(data["nodes"].size());
+        m_Ids.reserve(data["nodes"].size());
+        m_Index.Reserve(data["nodes"].size());
         for (const auto& [id, pos]: data["nodes"].items()) {
-            m_Graph[id].lat = pos["lat"];
-            m_Graph[id].lon = pos["lon"];
+            m_Index.Insert(parseId(id), static_cast<uint32_t>(m_Nodes.size()));
+            m_Ids.push_back(parseId(id));
+            Node& node = m_Nodes.emplace_back();
+            node.lat = pos["lat"];
+            node.lon = pos["lon"];
         }
 
         for (const auto& edge: data["edges"]){
-            std::string from = edge["from"];
-            std::string to = edge["to"];
+            uint32_t from = m_Index.At(parseId(edge["from"]));
+            uint32_t to = m_Index.At(parseId(edge["to"]));
             double weight = edge["weight"];
+            if (from == to) continue;
+
+            m_Nodes[from].neighbours.emplace_back(to, weight);
+        }
+    }
+
+    void loadBinary(const std::string& filePath) {
+        GraphFile file = ReadGraphFile(filePath);
+
+        m_Ids = std::move(file.ids);
+        m_Nodes.resize(m_Ids.size());
+        m_Index.Reserve(m_Ids.size());
+        for (uint32_t v = 0; v < m_Ids.size(); v++) {
+            m_Index.Insert(m_Ids[v], v);
+            m_Nodes[v].lat = file.lat[v];
+            m_Nodes[v].lon = file.lon[v];
+        }
+
+        for (size_t e = 0; e < file.from.size(); e++) {
+            if (file.from[e] == file.to[e]) continue;
+            m_Nodes[file.from[e]].neighbours.emplace_back(file.to[e], file.weight[e]);
+        }
+    }
+
+    void normalise(bool dropIsolated) {
+        std::vector<uint8_t> hasIncoming(m_Nodes.size(), 0);
+        for (auto& node: m_Nodes) {
+            auto& neighbours = node.neighbours;
+            std::sort(neighbours.begin(), neighbours.end());
+            neighbours.erase(std::unique(neighbours.begin(), neighbours.end(), [](const auto& a, const auto& b){
+                return a.first == b.first;
+            }), neighbours.end());
+
+            for (const auto& [to, _]: neighbours) hasIncoming[to] = 1;
+        }
+
+        if (!dropIsolated) return;
+
+        // Compact the arrays, keeping the surviving nodes in order
+        std::vector<uint32_t> kept;
+        for (uint32_t v = 0; v < m_Nodes.size(); v++) {
+            if (!m_Nodes[v].neighbours.empty() || hasIncoming[v]) kept.push_back(v);
+        }
+        renumber(kept);
+    }
+
+    // New index i is old node order[i]; nodes not listed are dropped and
+    // must have no edges. Runs before anything indexed by node is derived.
+    void renumber(const std::vector<uint32_t>& order) {
+        const uint32_t dropped = std::numeric_limits<uint32_t>::max();
+        std::vector<uint32_t> remap(m_Nodes.size(), dropped);
+        std::vector<Node> nodes;
+        std::vector<uint64_t> ids;
+        nodes.reserve(order.size());
+        ids.reserve(order.size());
+        for (uint32_t v: order) {
+            remap[v] = static_cast<uint32_t>(nodes.size());
+            nodes.push_back(std::move(m_Nodes[v]));
+            ids.push_back(m_Ids[v]);
+        }
+
+        m_Index = FlatIdMap();
+        m_Index.Reserve(nodes.size());
+        for (uint32_t v = 0; v < nodes.size(); v++) {
+            auto& neighbours = nodes[v].neighbours;
+            for (auto& arc: neighbours) arc.first = remap[arc.first];
+            std::sort(neighbours.begin(), neighbours.end());
+            m_Index.Insert(ids[v], v);
+        }
+        m_Nodes = std::move(nodes);
+        m_Ids = std::move(ids);
+    }
+
+    // Distance along a 2^16 x 2^16 Hilbert curve of the cell holding (x, y)
+    static uint64_t hilbertIndex(uint32_t x, uint32_t y) {
+        uint64_t d = 0;
+        for (uint32_t s = 1u << 15; s > 0; s >>= 1) {
+            uint32_t rx = (x & s) > 0, ry = (y & s) > 0;
+            d += static_cast<uint64_t>(s) * s * ((3 * rx) ^ ry);
+            if (ry == 0) {
+                if (rx == 1) {
+                    x = s - 1 - x;
+                    y = s - 1 - y;
+                }
+                std::swap(x, y);
+            }
+        }
+        return d;
+    }
+
+    std::vector<uint32_t> hilbertOrder() const {
+        double latMin = std::numeric_limits<double>::max(), latMax = std::numeric_limits<double>::lowest();
+        double lonMin = latMin, lonMax = latMax;
+        for (const Node& node: m_Nodes) {
+            latMin = std::min(latMin, node.lat); latMax = std::max(latMax, node.lat);
+            lonMin = std::min(lonMin, node.lon); lonMax = std::max(lonMax, node.lon);
+        }
+        double latScale = latMax > latMin ? 65535.0 / (latMax - latMin) : 0.0;
+        double lonScale = lonMax > lonMin ? 65535.0 / (lonMax - lonMin) : 0.0;
+
+        std::vector<std::pair<uint64_t, uint32_t>> keyed;
+        keyed.reserve(m_Nodes.size());
+        for (uint32_t v = 0; v < m_Nodes.size(); v++) {
+            keyed.emplace_back(hilbertIndex(static_cast<uint32_t>((m_Nodes[v].lon - lonMin) * lonScale),
+                                            static_cast<uint32_t>((m_Nodes[v].lat - latMin) * latScale)), v);
+        }
+        std::sort(keyed.begin(), keyed.end());
+
+        std::vector<uint32_t> order(keyed.size());
+        for (size_t i = 0; i < keyed.size(); i++) order[i] = keyed[i].second;
+        return order;
+    }
+
+    // Breadth-first over edges in both directions, one component after another
+    std::vector<uint32_t> bfsOrder() const {
+        std::vector<std::vector<uint32_t>> undirected(m_Nodes.size());
+        for (uint32_t u = 0; u < m_Nodes.size(); u++) {
+            for (const auto& [v, _]: m_Nodes[u].neighbours) {
+                undirected[u].push_back(v);
+                undirected[v].push_back(u);
+            }
+        }
+
+        std::vector<uint32_t> order;
+        std::vector<uint8_t> seen(m_Nodes.size(), 0);
+        for (uint32_t root = 0; root < m_Nodes.size(); root++) {
+            if (seen[root]) continue;
+            seen[root] = 1;
+
+            size_t head = order.size();
+            order.push_back(root);
+            while (head < order.size()) {
+                uint32_t u = order[head++];
+                for (uint32_t v: undirected[u]) {
+                    if (seen[v]) continue;
+                    seen[v] = 1;
+                    order.push_back(v);
+                }
+            }
+        }
+        return order;
+    }
+
+    // Planar x/y of every node about the centre of the bounding box
+    void project() {
+        double latMin = 0, latMax = 0, lonMin = 0, lonMax = 0;
+        for (uint32_t v = 0; v < m_Nodes.size(); v++) {
+            const Node& node = m_Nodes[v];
+            if (v == 0 || node.lat < latMin) latMin = node.lat;
+            if (v == 0 || node.lat > latMax) latMax = node.lat;
+            if (v == 0 || node.lon < lonMin) lonMin = node.lon;
+            if (v == 0 || node.lon > lonMax) lonMax = node.lon;
+        }
+        m_Projection = PlanarProjection((latMin + latMax) / 2, (lonMin + lonMax) / 2);
+        m_HeuristicScale = m_Projection.LowerBoundScale(latMin, latMax) * 0.999; // Float rounding
+
+        std::vector<double> lats(m_Nodes.size()), lons(m_Nodes.size());
+        for (uint32_t v = 0; v < m_Nodes.size(); v++) {
+            lats[v] = m_Nodes[v].lat;
+            lons[v] = m_Nodes[v].lon;
+        }
+        m_X.resize(m_Nodes.size());
+        m_Y.resize(m_Nodes.size());
+        simd::Affine(lons.data(), lons.size(), m_Projection.lon0, m_Projection.metresPerLon, m_X.data());
+        simd::Affine(lats.data(), lats.size(), m_Projection.lat0, m_Projection.metresPerLat, m_Y.data());
+    }
 
-            m_Graph[from].neighbours.emplace_back(to, weight);
-            m_Graph[to].neighbours.emplace_back(from, weight);
+    void collectSnapTargets() {
+        m_Snap = {};
+        m_SnapLargest = {};
+        for (uint32_t v = 0; v < m_Nodes.size(); v++) {
+            if (m_Nodes[v].contracted) continue;
+            m_Snap.x.push_back(m_X[v]); m_Snap.y.push_back(m_Y[v]); m_Snap.node.push_back(v);
+            if (m_Nodes[v].strongComponent != m_LargestStrongComponent) continue;
+            m_SnapLargest.x.push_back(m_X[v]); m_SnapLargest.y.push_back(m_Y[v]); m_SnapLargest.node.push_back(v);
         }
     }
 
-    inline std::unordered_map<std::string, Node> getGraph() { return m_Graph; }
+    // Union-find for weak components, iterative Tarjan for strong ones
+    void computeComponents() {
+        uint32_t n = static_cast<uint32_t>(m_Nodes.size());
+
+        std::vector<uint32_t> parent(n);
+        std::iota(parent.begin(), parent.end(), 0);
+        auto find = [&](uint32_t x) {
+            while (parent[x] != x) x = parent[x] = parent[parent[x]];
+            return x;
+        };
+        for (uint32_t u = 0; u < n; u++) {
+            for (const auto& [v, _]: m_Nodes[u].neighbours) parent[find(u)] = find(v);
+        }
+        for (uint32_t u = 0; u < n; u++) m_Nodes[u].component = find(u);
+
+        const uint32_t unvisited = std::numeric_limits<uint32_t>::max();
+        std::vector<uint32_t> order(n, unvisited), low(n), stack;
+        std::vector<uint8_t> onStack(n, 0);
+        std::vector<std::pair<uint32_t, size_t>> callStack; // (node, next edge)
+        std::vector<uint32_t> componentSize;
+        uint32_t counter = 0;
+
+        for (uint32_t root = 0; root < n; root++) {
+            if (order[root] != unvisited) continue;
+            callStack.emplace_back(root, 0);
+
+            while (!callStack.empty()) {
+                auto& [u, edge] = callStack.back();
+                if (edge == 0) {
+                    order[u] = low[u] = counter++;
+                    stack.push_back(u);
+                    onStack[u] = 1;
+                }
+
+                const auto& neighbours = m_Nodes[u].neighbours;
+                if (edge < neighbours.size()) {
+                    uint32_t v = neighbours[edge++].first;
+                    if (order[v] == unvisited) callStack.emplace_back(v, 0);
+                    else if (onStack[v]) low[u] = std::min(low[u], order[v]);
+                    continue;
+                }
+
+                if (low[u] == order[u]) {
+                    uint32_t id = static_cast<uint32_t>(componentSize.size()), size = 0, w;
+                    do {
+                        w = stack.back(); stack.pop_back();
+                        onStack[w] = 0;
+                        m_Nodes[w].strongComponent = id;
+                        size++;
+                    } while (w != u);
+                    componentSize.push_back(size);
+                }
+
+                uint32_t finished = u;
+                callStack.pop_back();
+                if (!callStack.empty()) {
+                    uint32_t caller = callStack.back().first;
+                    low[caller] = std::min(low[caller], low[finished]);
+                }
+            }
+        }
+
+        if (!componentSize.empty()) {
+            m_LargestStrongComponent = static_cast<uint32_t>(
+                std::max_element(componentSize.begin(), componentSize.end()) - componentSize.begin());
+        }
+    }
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,113 @@
+#ifndef GRAPH_FILE_HPP
+#define GRAPH_FILE_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Binary road graph as written by osm_import and read by Graph. Arrays are
+// stored back to back in host (little-endian) byte order so loading is a
+// handful of bulk reads:
+//
+//   char     magic[8]        "RTGRAPH1"
+//   uint64   nodeCount, edgeCount
+//   uint64   ids[nodeCount]
+//   double   lat[nodeCount], lon[nodeCount]
+//   uint32   from[edgeCount], to[edgeCount]   (indices into the node arrays)
+//   double   weight[edgeCount]                (metres)
+struct GraphFile {
+    static constexpr char Magic[8] = {'R', 'T', 'G', 'R', 'A', 'P', 'H', '1'};
+
+    std::vector<uint64_t> ids;
+    std::vector<double> lat, lon;
+    std::vector<uint32_t> from, to;
+    std::vector<double> weight;
+};
+
+namespace graph_file {
+    template<typename T>
+    inline void writeArray(std::FILE* f, const std::vector<T>& values) {
+        if (!values.empty() && std::fwrite(values.data(), sizeof(T), values.size(), f) != values.size()) {
+            throw std::runtime_error("Failed to write graph file\n");
+        }
+    }
+
+    template<typename T>
+    inline void readArray(std::FILE* f, std::vector<T>& values, uint64_t count) {
+        values.resize(count);
+        if (count > 0 && std::fread(values.data(), sizeof(T), count, f) != count) {
+            throw std::runtime_error("Truncated graph file\n");
+        }
+    }
+}
+
+inline bool IsGraphFile(const std::string& path) {
+    std::FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) return false;
+    char magic[8] = {};
+    bool match = std::fread(magic, 1, 8, f) == 8 && std::memcmp(magic, GraphFile::Magic, 8) == 0;
+    std::fclose(f);
+    return match;
+}
+
+inline void WriteGraphFile(const std::string& path, const GraphFile& graph) {
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) {
+        throw std::runtime_error("Failed to open " + path + " for writing\n");
+    }
+
+    uint64_t counts[2] = {graph.ids.size(), graph.from.size()};
+    std::fwrite(GraphFile::Magic, 1, 8, f);
+    std::fwrite(counts, sizeof(uint64_t), 2, f);
+    graph_file::writeArray(f, graph.ids);
+    graph_file::writeArray(f, graph.lat);
+    graph_file::writeArray(f, graph.lon);
+    graph_file::writeArray(f, graph.from);
+    graph_file::writeArray(f, graph.to);
+    graph_file::writeArray(f, graph.weight);
+
+    if (std::fclose(f) != 0) {
+        throw std::runtime_error("Failed to write graph file\n");
+    }
+}
+
+inline GraphFile ReadGraphFile(const std::string& path) {
+    std::FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) {
+        throw std::runtime_error("Failed to open the file\n");
+    }
+
+    GraphFile graph;
+    char magic[8];
+    uint64_t counts[2];
+    if (std::fread(magic, 1, 8, f) != 8 || std::memcmp(magic, GraphFile::Magic, 8) != 0
+        || std::fread(counts, sizeof(uint64_t), 2, f) != 2) {
+        std::fclose(f);
+        throw std::runtime_error("Not a binary graph file\n");
+    }
+
+    try {
+        graph_file::readArray(f, graph.ids, counts[0]);
+        graph_file::readArray(f, graph.lat, counts[0]);
+        graph_file::readArray(f, graph.lon, counts[0]);
+        graph_file::readArray(f, graph.from, counts[1]);
+        graph_file::readArray(f, graph.to, counts[1]);
+        graph_file::readArray(f, graph.weight, counts[1]);
+    } catch (...) {
+        std::fclose(f);
+        throw;
+    }
+    std::fclose(f);
+
+    for (uint64_t e = 0; e < counts[1]; e++) {
+        if (graph.from[e] >= counts[0] || graph.to[e] >= counts[0]) {
+            throw std::runtime_error("Edge references a missing node\n");
+        }
+    }
+    return graph;
+}
+
+#endif
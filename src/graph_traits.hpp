@@ -0,0 +1,47 @@
+#ifndef GRAPH_TRAITS_HPP
+#define GRAPH_TRAITS_HPP
+
+#include <cstdint>
+#include <type_traits>
+#include "csr_graph.hpp"
+#include "graph.hpp"
+
+// How searches and partitioners walk a graph type: node count, coordinates,
+// and out-edges with their weights as stored. RequireWeights<W>() rejects a
+// weight type the graph does not store, once, before any search runs.
+template<typename GraphT>
+struct GraphTraits;
+
+template<>
+struct GraphTraits<Graph> {
+    static uint32_t NodeCount(const Graph& graph) { return graph.NodeCount(); }
+    static double Lat(const Graph& graph, uint32_t v) { return graph.getGraph()[v].lat; }
+    static double Lon(const Graph& graph, uint32_t v) { return graph.getGraph()[v].lon; }
+
+    template<typename W>
+    static void RequireWeights(const Graph&) {
+        static_assert(std::is_floating_point_v<W>, "Graph stores metres; search a WeightFormat::Decimetres CsrGraph for fixed point");
+    }
+
+    template<typename W, typename Fn>
+    static void ForEachEdge(const Graph& graph, uint32_t u, Fn&& fn) {
+        for (const auto& [v, weight]: graph.getGraph()[u].neighbours) fn(v, static_cast<W>(weight));
+    }
+};
+
+template<>
+struct GraphTraits<CsrGraph> {
+    static uint32_t NodeCount(const CsrGraph& graph) { return graph.NodeCount(); }
+    static double Lat(const CsrGraph& graph, uint32_t v) { return graph.Lat(v); }
+    static double Lon(const CsrGraph& graph, uint32_t v) { return graph.Lon(v); }
+
+    template<typename W>
+    static void RequireWeights(const CsrGraph& graph) { graph.template RequireWeights<W>(); }
+
+    template<typename W, typename Fn>
+    static void ForEachEdge(const CsrGraph& graph, uint32_t u, Fn&& fn) {
+        for (uint32_t e = graph.Begin(u); e < graph.End(u); e++) fn(graph.Target(e), graph.template WeightAs<W>(e));
+    }
+};
+
+#endif
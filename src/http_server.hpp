@@ -0,0 +1,212 @@
+#ifndef HTTP_SERVER_HPP
+#define HTTP_SERVER_HPP
+
+#include <cctype>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include "thread_pool.hpp"
+
+struct HttpRequest {
+    std::string method, path;
+    std::unordered_map<std::string, std::string> query;
+};
+
+struct HttpResponse {
+    int status = 200;
+    std::string body;
+    std::string contentType = "application/json";
+};
+
+// Minimal HTTP/1.1 server bound to localhost. The accept loop runs on the
+// calling thread; every connection is handed to the pool and answered by
+// the handler registered for its path (one request per connection). Slow
+// clients time out so they cannot hold a worker, and connections beyond
+// the backlog limit are turned away rather than queued.
+class HttpServer {
+    public:
+    using Handler = std::function<HttpResponse(const HttpRequest&, size_t worker)>;
+
+    private:
+    static constexpr int TimeoutSeconds = 5;   // Per recv/send call
+    static constexpr size_t MaxPending = 1024; // Accepted connections waiting for a worker
+
+    int m_Socket = -1;
+    ThreadPool& m_Pool;
+    std::unordered_map<std::string, Handler> m_Routes;
+
+    public:
+    HttpServer(uint16_t port, ThreadPool& pool)
+        : m_Pool(pool)
+    {
+        m_Socket = socket(AF_INET, SOCK_STREAM, 0);
+        if (m_Socket < 0) {
+            throw std::runtime_error("Failed to create socket\n");
+        }
+
+        int reuse = 1;
+        setsockopt(m_Socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        if (bind(m_Socket, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(m_Socket, 128) < 0) {
+            close(m_Socket);
+            throw std::runtime_error("Failed to bind port " + std::to_string(port) + "\n");
+        }
+    }
+
+    ~HttpServer() {
+        if (m_Socket >= 0) close(m_Socket);
+    }
+
+    HttpServer(const HttpServer&) = delete;
+    HttpServer& operator=(const HttpServer&) = delete;
+
+    void Route(const std::string& path, Handler handler) {
+        m_Routes[path] = std::move(handler);
+    }
+
+    void Run() {
+        while (true) {
+            int client = accept(m_Socket, nullptr, nullptr);
+            if (client < 0) continue;
+
+            timeval timeout{TimeoutSeconds, 0};
+            setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+            setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+            if (m_Pool.Pending() >= MaxPending) {
+                sendResponse(client, {503, errorBody("Server busy")});
+                close(client);
+                continue;
+            }
+
+            m_Pool.Submit([this, client](size_t worker){
+                handleConnection(client, worker);
+                close(client);
+            });
+        }
+    }
+
+    private:
+    void handleConnection(int client, size_t worker) {
+        std::string raw;
+        char buffer[4096];
+        while (raw.find("\r\n\r\n") == std::string::npos && raw.size() < 16384) {
+            ssize_t n = recv(client, buffer, sizeof(buffer), 0);
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                sendResponse(client, {408, errorBody("Request timed out")});
+                return;
+            }
+            if (n <= 0) return;
+            raw.append(buffer, static_cast<size_t>(n));
+        }
+
+        HttpRequest request;
+        HttpResponse response;
+        if (!parseRequest(raw, request)) {
+            response = {400, errorBody("Malformed request")};
+        } else if (auto it = m_Routes.find(request.path); it == m_Routes.end()) {
+            response = {404, errorBody("Unknown endpoint")};
+        } else {
+            try {
+                response = it->second(request, worker);
+            } catch (const std::exception& e) {
+                response = {400, errorBody(e.what())};
+            }
+        }
+        sendResponse(client, response);
+    }
+
+    static void sendResponse(int client, const HttpResponse& response) {
+        std::string out = "HTTP/1.1 " + std::to_string(response.status) + " " + statusText(response.status) + "\r\n"
+            "Content-Type: " + response.contentType + "\r\n"
+            "Content-Length: " + std::to_string(response.body.size()) + "\r\n"
+            "Connection: close\r\n\r\n" + response.body;
+
+        size_t sent = 0;
+        while (sent < out.size()) {
+            ssize_t n = send(client, out.data() + sent, out.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) return;
+            sent += static_cast<size_t>(n);
+        }
+    }
+
+    static bool parseRequest(const std::string& raw, HttpRequest& request) {
+        size_t methodEnd = raw.find(' ');
+        if (methodEnd == std::string::npos) return false;
+        size_t targetEnd = raw.find(' ', methodEnd + 1);
+        if (targetEnd == std::string::npos) return false;
+
+        request.method = raw.substr(0, methodEnd);
+        std::string target = raw.substr(methodEnd + 1, targetEnd - methodEnd - 1);
+
+        size_t queryStart = target.find('?');
+        request.path = target.substr(0, queryStart);
+        if (queryStart == std::string::npos) return true;
+
+        std::string query = target.substr(queryStart + 1);
+        size_t pos = 0;
+        while (pos <= query.size()) {
+            size_t end = query.find('&', pos);
+            if (end == std::string::npos) end = query.size();
+
+            std::string pair = query.substr(pos, end - pos);
+            size_t eq = pair.find('=');
+            if (eq != std::string::npos) {
+                request.query[urlDecode(pair.substr(0, eq))] = urlDecode(pair.substr(eq + 1));
+            }
+            pos = end + 1;
+        }
+        return true;
+    }
+
+    static std::string urlDecode(const std::string& in) {
+        std::string out;
+        for (size_t i = 0; i < in.size(); i++) {
+            if (in[i] == '%' && i + 2 < in.size() && std::isxdigit(in[i + 1]) && std::isxdigit(in[i + 2])) {
+                out += static_cast<char>(std::stoi(in.substr(i + 1, 2), nullptr, 16));
+                i += 2;
+            } else if (in[i] == '+') {
+                out += ' ';
+            } else {
+                out += in[i];
+            }
+        }
+        return out;
+    }
+
+    static std::string errorBody(const std::string& message) {
+        std::string body = "{\"error\":\"";
+        for (char c: message) {
+            if (c == '"' || c == '\\') body += '\\';
+            if (static_cast<unsigned char>(c) >= 0x20) body += c;
+        }
+        return body + "\"}";
+    }
+
+    static const char* statusText(int status) {
+        switch (status) {
+            case 200: return "OK";
+            case 400: return "Bad Request";
+            case 404: return "Not Found";
+            case 408: return "Request Timeout";
+            case 503: return "Service Unavailable";
+            default: return "Internal Server Error";
+        }
+    }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,92 @@
+#ifndef ISOCHRONE_HPP
+#define ISOCHRONE_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "graph.hpp"
+
+// Reachable area rasterised onto a square grid in world (map pixel) space.
+// A cell is set if any reachable node or reachable part of a road falls in
+// it; Renderer::DrawIsochrone() fills the set cells row by row.
+struct IsochroneGrid {
+    float originX = 0, originY = 0, cellSize = 1;
+    int cols = 0, rows = 0;
+    std::vector<uint8_t> cells;
+
+    inline bool At(int col, int row) const { return cells[static_cast<size_t>(row) * cols + col]; }
+};
+
+// `reachable` is the output of Pathfinder::SearchWithin() for the same limit;
+// `project(lat, lon)` returns world coordinates as a pair of floats.
+// Contracted edges are walked along their folded nodes, so bends in a
+// chain are covered rather than the chord between its ends.
+template<typename Projection>
+IsochroneGrid BuildIsochroneGrid(const Graph& graph,
+                                 const std::vector<std::pair<uint32_t, double>>& reachable,
+                                 double limit, float cellSize, Projection project) {
+    IsochroneGrid grid;
+    grid.cellSize = cellSize;
+    if (reachable.empty()) return grid;
+
+    const auto& G = graph.getGraph();
+    std::vector<std::pair<float, float>> points;
+    // Samples the first `fraction` of the segment (x0, y0) -> (x1, y1)
+    auto segment = [&](float x0, float y0, float x1, float y1, double fraction) {
+        float dx = (x1 - x0) * static_cast<float>(fraction), dy = (y1 - y0) * static_cast<float>(fraction);
+        int steps = static_cast<int>(std::ceil(std::hypot(dx, dy) / (cellSize * 0.5f)));
+        for (int i = 1; i <= steps; i++) {
+            float t = static_cast<float>(i) / steps;
+            points.emplace_back(x0 + dx * t, y0 + dy * t);
+        }
+    };
+
+    // Roads leaving a reachable node are covered up to the remaining budget
+    for (const auto& [v, d]: reachable) {
+        const Node& node = G[v];
+        auto [x0, y0] = project(node.lat, node.lon);
+        points.emplace_back(x0, y0);
+
+        for (const auto& [to, weight]: node.neighbours) {
+            double budget = limit - d;
+            if (budget <= 0) continue;
+
+            // Polyline from v through the folded nodes to `to`
+            float fromX = x0, fromY = y0;
+            double from = 0;
+            auto leg = [&](uint32_t w, double at) {
+                if (from >= budget) return;
+                auto [x1, y1] = project(G[w].lat, G[w].lon);
+                double fraction = at > from ? std::min(1.0, (budget - from) / (at - from)) : 1.0;
+                segment(fromX, fromY, x1, y1, fraction);
+                fromX = x1; fromY = y1; from = at;
+            };
+            if (const auto* via = graph.Via(v, to)) {
+                for (const auto& [w, offset]: *via) leg(w, offset);
+            }
+            leg(to, weight);
+        }
+    }
+
+    float minX = points[0].first, maxX = minX, minY = points[0].second, maxY = minY;
+    for (const auto& [x, y]: points) {
+        minX = std::min(minX, x); maxX = std::max(maxX, x);
+        minY = std::min(minY, y); maxY = std::max(maxY, y);
+    }
+
+    grid.originX = minX;
+    grid.originY = minY;
+    grid.cols = static_cast<int>((maxX - minX) / cellSize) + 1;
+    grid.rows = static_cast<int>((maxY - minY) / cellSize) + 1;
+    grid.cells.assign(static_cast<size_t>(grid.cols) * grid.rows, 0);
+
+    for (const auto& [x, y]: points) {
+        int col = std::min(grid.cols - 1, static_cast<int>((x - minX) / cellSize));
+        int row = std::min(grid.rows - 1, static_cast<int>((y - minY) / cellSize));
+        grid.cells[static_cast<size_t>(row) * grid.cols + col] = 1;
+    }
+    return grid;
+}
+
+#endif
\ No newline at end of file
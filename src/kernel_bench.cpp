@@ -0,0 +1,107 @@
+#include "graph.hpp"
+#include "simd_kernels.hpp"
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <random>
+
+// Microbenchmark for simd_kernels.hpp: runs every kernel at each level the
+// CPU supports on the bundled graph's coordinates and on a large synthetic
+// point set, checks the output against the scalar version and reports the
+// time per call and the speed-up over scalar.
+//
+//   ./kernel_bench [graph.json] [synthetic_points]
+
+static double timeCall(const std::function<void()>& call) {
+    // Repeat until at least 0.2 s have passed, then report the mean
+    size_t reps = 0;
+    auto start = std::chrono::steady_clock::now();
+    double elapsed = 0;
+    do {
+        call();
+        reps++;
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (elapsed < 0.2);
+    return elapsed / reps;
+}
+
+struct PointSet {
+    std::string name;
+    std::vector<float> x, y;
+    std::vector<double> lat;
+};
+
+static void bench(const PointSet& points) {
+    uint32_t n = static_cast<uint32_t>(points.x.size());
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<uint32_t> pick(0, n - 1);
+
+    // A* style batch: scattered node ids, as gathered from adjacency lists
+    std::vector<uint32_t> batch(std::min<uint32_t>(n, 4096));
+    for (auto& v: batch) v = pick(rng);
+    std::vector<float> heuristics(batch.size()), reference(batch.size());
+    std::vector<float> projected(n), projectedReference(n);
+
+    float qx = points.x[pick(rng)] + 3.5f, qy = points.y[pick(rng)] - 2.0f;
+    uint32_t nearestReference = 0;
+
+    std::cout << points.name << " (" << n << " points)" << std::endl;
+    std::cout << "  " << std::left << std::setw(12) << "kernel" << std::setw(8) << "level"
+              << std::right << std::setw(14) << "ns/call" << std::setw(10) << "speed-up" << "  check" << std::endl;
+
+    const simd::Level levels[] = {simd::Level::Scalar, simd::Level::Sse2, simd::Level::Avx2};
+    double scalarTime[3] = {};
+    for (simd::Level level: levels) {
+        if (level > simd::Supported()) break;
+        simd::ActiveLevel() = level;
+
+        volatile uint32_t sink = 0;
+        double times[3] = {
+            timeCall([&]{ sink = simd::Nearest(points.x.data(), points.y.data(), n, qx, qy); }),
+            timeCall([&]{ simd::DistancesTo(points.x.data(), points.y.data(), batch.data(), batch.size(), qx, qy, 0.999f, heuristics.data()); }),
+            timeCall([&]{ simd::Affine(points.lat.data(), n, 23.25, 111195.0, projected.data()); })
+        };
+
+        uint32_t nearest = simd::Nearest(points.x.data(), points.y.data(), n, qx, qy);
+        if (level == simd::Level::Scalar) {
+            std::copy(times, times + 3, scalarTime);
+            nearestReference = nearest;
+            reference = heuristics;
+            projectedReference = projected;
+        }
+        bool ok[3] = {nearest == nearestReference, heuristics == reference, projected == projectedReference};
+
+        const char* names[] = {"nearest", "heuristic", "project"};
+        for (int k = 0; k < 3; k++) {
+            std::cout << "  " << std::left << std::setw(12) << names[k] << std::setw(8) << simd::LevelName(level)
+                      << std::right << std::fixed << std::setprecision(1) << std::setw(14) << times[k] * 1e9
+                      << std::setprecision(2) << std::setw(9) << scalarTime[k] / times[k] << "x"
+                      << "  " << (ok[k] ? "ok" : "MISMATCH") << std::endl;
+        }
+    }
+    simd::ActiveLevel() = simd::Supported();
+}
+
+int main(int argc, char** argv){
+    std::string graphPath = argc > 1 ? argv[1] : "./maps/map_graph.json";
+    size_t synthetic = argc > 2 ? std::stoul(argv[2]) : 1000000;
+
+    Graph graph(graphPath);
+    PointSet bundled{"graph", graph.X(), graph.Y(), {}};
+    for (const Node& node: graph.getGraph()) bundled.lat.push_back(node.lat);
+
+    PointSet random{"synthetic", {}, {}, {}};
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> coordinate(-50000.0f, 50000.0f);
+    std::uniform_real_distribution<double> latitude(-60.0, 60.0);
+    for (size_t i = 0; i < synthetic; i++) {
+        random.x.push_back(coordinate(rng));
+        random.y.push_back(coordinate(rng));
+        random.lat.push_back(latitude(rng));
+    }
+
+    std::cout << "Supported: " << simd::LevelName(simd::Supported()) << std::endl;
+    bench(bundled);
+    bench(random);
+    return 0;
+}
@@ -1,8 +1,13 @@
 #include "graph.hpp"
 #include "pathfinder.hpp"
 #include "renderer.hpp"
-#include <unordered_map>
+#include "search.hpp"
+#include <chrono>
+#include <future>
 #include <iomanip>
+#include <memory>
+#include <sstream>
+#include <thread>
 
 const int width = 1200;
 const int height = 800;
@@ -12,125 +17,262 @@ struct NodePosition {
     Color color;
 };
 
-int main(){
-    std::freopen("/dev/null", "w", stderr); // Silence MacOS
-    SetTraceLogLevel(LOG_NONE); // Silence Raylib
-    
-    Renderer renderer(width, height, "Dijkstra-Pathfinder");
-    renderer.LoadMap("./maps/map.png");
-    
-    Graph graph("./maps/map_graph.json");
-    auto G = graph.getGraph();
-    
-    
-    // Load bounds
-    std::ifstream f("./maps/map_bounds.json");
+struct MapBounds {
+    double lat_min, lat_max, lon_min, lon_max;
+    double image_width = 0, image_height = 0; // From the Python script, if recorded
+};
+
+struct Query {
+    double lat1, lon1, lat2, lon2;
+};
+
+// Search used for the route itself; picked on the command line
+struct RouteOptions {
+    Algorithm algorithm = Algorithm::Dijkstra;
+    WeightFormat weights = WeightFormat::Double;
+};
+
+// Graph planar x/y -> map pixel. The Python script maps lat/lon linearly
+// onto the image, and the planar projection is linear in lat/lon too, so
+// this is one scale and offset per axis.
+struct MapProjection {
+    PlanarProjection planar;
+    float originX, originY, scaleX, scaleY;
+
+    MapProjection(const PlanarProjection& p, const MapBounds& bounds, double map_width, double map_height)
+        : planar(p), originX(p.X(bounds.lon_min)), originY(p.Y(bounds.lat_max)),
+          scaleX(static_cast<float>(map_width / (p.X(bounds.lon_max) - p.X(bounds.lon_min)))),
+          scaleY(static_cast<float>(map_height / (p.Y(bounds.lat_max) - p.Y(bounds.lat_min)))) {}
+
+    inline Vector2 Pixel(float x, float y) const { return {(x - originX) * scaleX, (originY - y) * scaleY}; }
+    inline Vector2 operator()(double lat, double lon) const { return Pixel(planar.X(lon), planar.Y(lat)); }
+};
+
+// Result of one routing query, computed off the main thread
+struct RouteScene {
+    std::vector<Color> nodeColors; // Parallel to the drawn nodes
+    std::vector<Vector2> pathPositions;
+    IsochroneGrid isochrone;
+};
+
+template<typename T>
+static bool ready(const std::future<T>& future) {
+    return future.valid() && future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+static MapBounds loadBounds(const std::string& path) {
+    std::ifstream f(path);
     json bounds; f >> bounds; f.close();
-    
-    // Extract bounds with verification
-    double lat_max = bounds["lat_max"].get<double>();
-    double lat_min = bounds["lat_min"].get<double>();
-    double lon_max = bounds["lon_max"].get<double>();
-    double lon_min = bounds["lon_min"].get<double>();
-    
-    // Get actual map dimensions
-    double actual_map_width = static_cast<double>(renderer.MapWidth());
-    double actual_map_height = static_cast<double>(renderer.MapHeight());
-    
-    // Debug output
-    std::cout << std::fixed << std::setprecision(6);
-    std::cout << "Bounds: lat(" << lat_min << ", " << lat_max << "), ";
-    std::cout << "lon(" << lon_min << ", " << lon_max << ")" << std::endl;
-    std::cout << "Map size: " << actual_map_width << "x" << actual_map_height << std::endl;
-    
-    // Check if we have image dimensions from Python script
-    double expected_width = actual_map_width;
-    double expected_height = actual_map_height;
-    
+
+    MapBounds out;
+    out.lat_max = bounds["lat_max"].get<double>();
+    out.lat_min = bounds["lat_min"].get<double>();
+    out.lon_max = bounds["lon_max"].get<double>();
+    out.lon_min = bounds["lon_min"].get<double>();
     if (bounds.contains("image_width") && bounds.contains("image_height")) {
-        expected_width = bounds["image_width"].get<double>();
-        expected_height = bounds["image_height"].get<double>();
-        
-        std::cout << "Expected size from Python: " << expected_width << "x" << expected_height << std::endl;
-        
-        if (std::abs(actual_map_width - expected_width) > 1.0 || 
-        std::abs(actual_map_height - expected_height) > 1.0) {
-            std::cout << "WARNING: Image size mismatch detected!" << std::endl;
-        }
+        out.image_width = bounds["image_width"].get<double>();
+        out.image_height = bounds["image_height"].get<double>();
     }
-    
-    // Calculate coordinate ranges
-    double lat_range = lat_max - lat_min;
-    double lon_range = lon_max - lon_min;
-    
-    std::cout << "Coordinate ranges: lat=" << lat_range << ", lon=" << lon_range << std::endl;
-    
-    // Pre-calculate all node positions using the EXACT same formula as Python
-    std::unordered_map<std::string, NodePosition> nodePositions;
-    
-    
-    double lat1, lon1, lat2, lon2;
-    std::cout << "Enter the start position (latitude, longitude): ";
-    std::cin >> lat1 >> lon1;
-    std::cout << "Enter the end position (latitude, longitude): ";
-    std::cin >> lat2 >> lon2;
+    return out;
+}
 
-    string start_node, end_node;
-    double min_distance1 = std::numeric_limits<double>::max();
-    double min_distance2 = std::numeric_limits<double>::max();
+static std::unique_ptr<Graph> loadGraph() {
+    // Prefer the binary graph from osm_import when present
+    auto graph = std::make_unique<Graph>(IsGraphFile("./maps/map_graph.bin") ? "./maps/map_graph.bin" : "./maps/map_graph.json");
+    size_t folded = graph->ContractChains(); // Shrinks the search space
+    std::cout << "Contracted " << folded << " chain nodes, " << graph->NodeCount() - folded << " remain" << std::endl;
+    return graph;
+}
 
-    for (const auto& [id, node]: G){
-        double distance1 = pow(node.lat - lat1, 2) + pow(node.lon - lon1, 2);
+static RouteScene buildRoute(const Graph& graph, const std::vector<uint32_t>& drawnNodes, const MapProjection& project,
+                             const Query& query, const RouteOptions& options, double isochrone_limit,
+                             const std::string& facility_list) {
+    const auto& G = graph.getGraph();
+    uint32_t start_node = graph.NearestNode(query.lat1, query.lon1);
+    uint32_t end_node = graph.NearestNode(query.lat2, query.lon2);
 
-        if (distance1 < min_distance1){
-            min_distance1 = distance1;
-            start_node = id;
-        }
+    // Different components: reject without searching
+    if (!graph.Connected(start_node, end_node)){
+        throw std::runtime_error("No path from " + std::to_string(graph.IdOf(start_node)) + " to " + std::to_string(graph.IdOf(end_node)) + " exists.");
+    }
 
-        double distance2 = pow(node.lat - lat2, 2) + pow(node.lon - lon2, 2);
-        if (distance2 < min_distance2){
-            min_distance2 = distance2;
-            end_node = id;
-        }
+    RouteSearch search(graph);
+    auto route = search.Route(start_node, end_node, options.algorithm, options.weights);
+    if (route.path.empty()){
+        throw std::runtime_error("No path from " + std::to_string(graph.IdOf(start_node)) + " to " + std::to_string(graph.IdOf(end_node)) + " exists.");
     }
+    std::cout << "Route: " << route.distance << " m, " << route.settled << " nodes settled" << std::endl;
 
-    
-    Pathfinder dijkstra(G, start_node, end_node);
-    const auto& dist = dijkstra.GetDistances();
+    Pathfinder dijkstra(graph); // Range and facility searches
 
-    if (dist.at(end_node) == std::numeric_limits<double>::infinity()){
-        std::cout << "No path from " << start_node << " to " << end_node << " exists." << std::endl;
-        return 1;
+    // Network Voronoi partition by nearest facility
+    std::vector<uint32_t> facilities;
+    std::istringstream facility_stream(facility_list);
+    for (std::string item; std::getline(facility_stream, item, ';');) {
+        double lat, lon; char comma;
+        std::istringstream point(item);
+        if (point >> lat >> comma >> lon) facilities.push_back(graph.NearestNode(lat, lon));
     }
-    
-    for (const auto& [id, node] : G) {
-        // Use EXACT same calculation as Python script
-        double x = ((node.lon - lon_min) / lon_range) * actual_map_width;
-        double y = ((lat_max - node.lat) / lat_range) * actual_map_height;
-        
+
+    std::vector<size_t> facility_index(G.size());
+    for (size_t i = 0; i < facilities.size(); i++) facility_index[facilities[i]] = i;
+    FacilityPartition partition;
+    if (!facilities.empty()) partition = dijkstra.NearestFacilities(facilities);
+
+    RouteScene scene;
+    scene.nodeColors.reserve(drawnNodes.size());
+    for (uint32_t id: drawnNodes) {
         Color nodeColor = GREEN;
+        if (!partition.owner.empty() && partition.owner[id] != FacilityPartition::NoNode) {
+            nodeColor = Renderer::PaletteColor(facility_index[partition.owner[id]]);
+        }
         if (id == start_node) {
             nodeColor = BLUE;
         } else if (id == end_node) {
             nodeColor = RED;
         }
-        
-        nodePositions[id] = {
-            {static_cast<float>(x), static_cast<float>(y)}, 
-            nodeColor
-        };
+        scene.nodeColors.push_back(nodeColor);
     }
-    
-    // Pre-calculate path positions
-    std::vector<Vector2> pathPositions;
-    auto path = dijkstra.GetPath();
+
+    // Pre-calculate path positions, restoring the contracted chain nodes
+    auto path = graph.ExpandPath(route.path);
     if (path.size() > 1) {
-        for (const auto& nodeId : path) {
-            pathPositions.push_back(nodePositions[nodeId].pos);
-        }
+        for (uint32_t v : path) scene.pathPositions.push_back(project.Pixel(graph.X()[v], graph.Y()[v]));
     }
 
+    if (isochrone_limit > 0) {
+        auto reachable = dijkstra.SearchWithin(start_node, isochrone_limit);
+        scene.isochrone = BuildIsochroneGrid(graph, reachable, isochrone_limit, 40.0f, [&](double lat, double lon){
+            Vector2 p = project(lat, lon);
+            return std::make_pair(p.x, p.y);
+        });
+        std::cout << reachable.size() << " nodes within " << isochrone_limit << " m of the start" << std::endl;
+    }
+    return scene;
+}
+
+int main(int argc, char** argv){
+    // Optional: shade everything within this many metres of the start
+    double isochrone_limit = argc > 1 ? std::stod(argv[1]) : 0.0;
+    // Optional: "lat,lon;lat,lon;..." facilities; nodes are coloured by the nearest one
+    std::string facility_list = argc > 2 ? argv[2] : "";
+    // Optional: "dijkstra" (default) or "astar", then "double" (default) or "fixed" weights
+    RouteOptions route_options;
+    if (argc > 3 && std::string(argv[3]) == "astar") route_options.algorithm = Algorithm::AStar;
+    if (argc > 4 && std::string(argv[4]) == "fixed") route_options.weights = WeightFormat::Decimetres;
+
+    auto launched = std::chrono::steady_clock::now();
+    std::freopen("/dev/null", "w", stderr); // Silence MacOS
+    SetTraceLogLevel(LOG_NONE); // Silence Raylib
+
+    Renderer renderer(width, height, "Dijkstra-Pathfinder");
+
+    // Image decode, graph build and bounds parsing run concurrently on worker
+    // threads; the window stays live meanwhile. Only the texture upload (GPU)
+    // happens on this thread, a few row bands per frame once the decoded
+    // image is ready.
+    auto imageFuture = std::async(std::launch::async, Renderer::DecodeMap, std::string("./maps/map.png"));
+    auto graphFuture = std::async(std::launch::async, loadGraph);
+    auto boundsFuture = std::async(std::launch::async, loadBounds, std::string("./maps/map_bounds.json"));
+
+    // The console prompt can be answered while loading. Detached, so closing
+    // the window never waits on stdin.
+    std::promise<Query> queryPromise;
+    auto queryFuture = queryPromise.get_future();
+    std::thread([promise = std::move(queryPromise)]() mutable {
+        Query query;
+        std::cout << "Enter the start position (latitude, longitude): ";
+        std::cin >> query.lat1 >> query.lon1;
+        std::cout << "Enter the end position (latitude, longitude): ";
+        std::cin >> query.lat2 >> query.lon2;
+        if (std::cin) promise.set_value(query);
+        else promise.set_exception(std::make_exception_ptr(std::runtime_error("Invalid start/end position")));
+    }).detach();
+
+    std::unique_ptr<Graph> graph;
+    std::unique_ptr<MapProjection> projection;
+    MapBounds bounds;
+    bool haveBounds = false, mapFailed = false, firstFrame = true;
+
+    std::vector<uint32_t> drawnNodes;
+    std::vector<NodePosition> nodePositions;
+    std::future<RouteScene> routeFuture;
+    RouteScene scene;
+
     while (renderer.Running()){
+        if (ready(imageFuture)) {
+            Image image = imageFuture.get();
+            if (!image.data) {
+                mapFailed = true;
+                std::cout << "Failed to load ./maps/map.png, routing without the map" << std::endl;
+            }
+            renderer.BeginMapUpload(image);
+        }
+        bool mapUploaded = renderer.ContinueMapUpload();
+        if (ready(graphFuture)) graph = graphFuture.get();
+        if (ready(boundsFuture)) {
+            bounds = boundsFuture.get();
+            haveBounds = true;
+        }
+
+        if (!projection && graph && haveBounds && (renderer.MapLoaded() || mapFailed)) {
+            // Get actual map dimensions; without the image, the size it was
+            // rendered at, or else one pixel per metre
+            double actual_map_width = static_cast<double>(renderer.MapWidth());
+            double actual_map_height = static_cast<double>(renderer.MapHeight());
+            if (mapFailed) {
+                const PlanarProjection& planar = graph->Projection();
+                actual_map_width = bounds.image_width > 0 ? bounds.image_width : planar.X(bounds.lon_max) - planar.X(bounds.lon_min);
+                actual_map_height = bounds.image_height > 0 ? bounds.image_height : planar.Y(bounds.lat_max) - planar.Y(bounds.lat_min);
+            }
+            projection = std::make_unique<MapProjection>(graph->Projection(), bounds, actual_map_width, actual_map_height);
+
+            // Debug output
+            std::cout << std::fixed << std::setprecision(6);
+            std::cout << "Bounds: lat(" << bounds.lat_min << ", " << bounds.lat_max << "), ";
+            std::cout << "lon(" << bounds.lon_min << ", " << bounds.lon_max << ")" << std::endl;
+            std::cout << "Map size: " << actual_map_width << "x" << actual_map_height << std::endl;
+
+            // Check if we have image dimensions from Python script
+            if (!mapFailed && bounds.image_width > 0 && bounds.image_height > 0) {
+                std::cout << "Expected size from Python: " << bounds.image_width << "x" << bounds.image_height << std::endl;
+
+                if (std::abs(actual_map_width - bounds.image_width) > 1.0 ||
+                std::abs(actual_map_height - bounds.image_height) > 1.0) {
+                    std::cout << "WARNING: Image size mismatch detected!" << std::endl;
+                }
+            }
+        }
+
+        // Pre-calculate all node positions once the projection exists;
+        // folded chain nodes are drawn too and coloured with their chain
+        if (projection && nodePositions.empty()) {
+            const auto& X = graph->X();
+            const auto& Y = graph->Y();
+            for (uint32_t id = 0; id < graph->NodeCount(); id++) {
+                drawnNodes.push_back(id);
+                nodePositions.push_back({projection->Pixel(X[id], Y[id]), GREEN});
+            }
+        }
+
+        // Routing is enabled once everything it projects onto is loaded
+        if (!nodePositions.empty() && ready(queryFuture)) {
+            try {
+                routeFuture = std::async(std::launch::async, buildRoute, std::cref(*graph), std::cref(drawnNodes),
+                                         *projection, queryFuture.get(), route_options, isochrone_limit, facility_list);
+            } catch (const std::exception& e) {
+                std::cout << e.what() << std::endl;
+            }
+        }
+        if (ready(routeFuture)) {
+            try {
+                scene = routeFuture.get();
+                for (size_t i = 0; i < nodePositions.size(); i++) nodePositions[i].color = scene.nodeColors[i];
+            } catch (const std::exception& e) {
+                std::cout << e.what() << std::endl;
+            }
+        }
+
         renderer.HandleInput();
 
         BeginDrawing();
@@ -138,19 +280,21 @@ int main(){
 
         BeginMode2D(renderer.GetCamera());
         renderer.DrawMap();
+        renderer.DrawIsochrone(scene.isochrone, Fade(SKYBLUE, 0.4f));
 
         // Draw all nodes
-        for (const auto& [id, nodePos] : nodePositions) {
+        for (const auto& nodePos : nodePositions) {
             DrawCircleV(nodePos.pos, 18.0f, nodePos.color);
-            
+
             // Draw a small cross in the center
-            DrawLineEx({nodePos.pos.x - 4, nodePos.pos.y}, 
+            DrawLineEx({nodePos.pos.x - 4, nodePos.pos.y},
                       {nodePos.pos.x + 4, nodePos.pos.y}, 2.0f, BLACK);
-            DrawLineEx({nodePos.pos.x, nodePos.pos.y - 4}, 
+            DrawLineEx({nodePos.pos.x, nodePos.pos.y - 4},
                       {nodePos.pos.x, nodePos.pos.y + 4}, 2.0f, BLACK);
         }
 
         // Draw the path
+        const auto& pathPositions = scene.pathPositions;
         if (pathPositions.size() > 1) {
             for (size_t i = 0; i < pathPositions.size() - 1; i++) {
                 DrawLineEx(pathPositions[i], pathPositions[i + 1], 20.0f, ORANGE);
@@ -158,8 +302,24 @@ int main(){
         }
 
         EndMode2D();
+
+        std::vector<std::string> status;
+        if (mapFailed) status.push_back("No map image");
+        else if (!renderer.MapLoaded()) status.push_back("Decoding map image");
+        else if (!mapUploaded) status.push_back("Uploading map " + std::to_string(static_cast<int>(renderer.MapUploadProgress() * 100)) + "%");
+        if (!graph) status.push_back("Building graph");
+        if (graph && queryFuture.valid()) status.push_back("Enter start and end positions in the console");
+        if (routeFuture.valid()) status.push_back("Routing");
+        renderer.DrawStatus(status);
+
         EndDrawing();
+
+        if (firstFrame) {
+            firstFrame = false;
+            std::cout << "First frame after " << std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - launched).count() << " ms" << std::endl;
+        }
     }
-    
+
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,251 @@
+#include "flat_id_map.hpp"
+#include "graph_file.hpp"
+#include "pbf_reader.hpp"
+#include "work_stealing_pool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <nlohmann/json.hpp>
+
+// Offline replacement for the graph half of map_loader.py: reads a local
+// .osm.pbf extract, keeps the ways a car may use, and writes the routing
+// graph (map_graph.bin) and its bounds (map_bounds.json). Like osmnx's
+// simplified output, only way ends and intersections become nodes; edge
+// weights are the great-circle length in metres along the way geometry.
+//
+//   ./osm_import <extract.osm.pbf> [output_dir] [threads]
+//
+// Blocks are decoded in parallel in three passes: ways, then coordinates of
+// the nodes they use, then edges. Only the ids are merged on one thread.
+
+using json = nlohmann::json;
+
+enum class Direction : uint8_t { Both, Forward, Backward };
+
+// Drivable ways of one block, node refs flattened
+struct WayBatch {
+    std::vector<uint64_t> refs;
+    std::vector<uint32_t> offsets{0};
+    std::vector<Direction> directions;
+};
+
+struct EdgeBatch {
+    std::vector<uint32_t> from, to;
+    std::vector<double> weight;
+};
+
+struct Scratch {
+    std::vector<uint8_t> raw, data;
+};
+
+// Same highway classes as osmnx's "drive" network
+static bool drivable(const std::vector<OsmTag>& tags, Direction& direction) {
+    static const std::string_view roads[] = {
+        "motorway", "trunk", "primary", "secondary", "tertiary", "unclassified", "residential",
+        "motorway_link", "trunk_link", "primary_link", "secondary_link", "tertiary_link",
+        "living_street", "road"
+    };
+
+    std::string_view highway, oneway, junction;
+    for (const auto& [key, value]: tags) {
+        if (key == "highway") highway = value;
+        else if (key == "oneway") oneway = value;
+        else if (key == "junction") junction = value;
+        else if (key == "area" && value == "yes") return false;
+        else if ((key == "access" || key == "motor_vehicle" || key == "motorcar")
+                 && (value == "no" || value == "private")) return false;
+    }
+    if (std::find(std::begin(roads), std::end(roads), highway) == std::end(roads)) return false;
+
+    direction = Direction::Both;
+    if (oneway == "yes" || oneway == "true" || oneway == "1") direction = Direction::Forward;
+    else if (oneway == "-1" || oneway == "reverse") direction = Direction::Backward;
+    else if (oneway.empty() && (junction == "roundabout" || highway == "motorway")) direction = Direction::Forward;
+    return true;
+}
+
+static double haversine(double lat1, double lon1, double lat2, double lon2) {
+    constexpr double EarthRadius = 6371009.0, Rad = M_PI / 180.0;
+    double dLat = (lat2 - lat1) * Rad, dLon = (lon2 - lon1) * Rad;
+    double a = std::sin(dLat / 2) * std::sin(dLat / 2)
+             + std::cos(lat1 * Rad) * std::cos(lat2 * Rad) * std::sin(dLon / 2) * std::sin(dLon / 2);
+    return 2 * EarthRadius * std::asin(std::min(1.0, std::sqrt(a)));
+}
+
+int main(int argc, char** argv){
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <extract.osm.pbf> [output_dir] [threads]" << std::endl;
+        return 1;
+    }
+    std::string inputPath = argv[1];
+    std::string outputDir = argc > 2 ? argv[2] : "./maps";
+    size_t threads = argc > 3 ? std::stoul(argv[3]) : std::thread::hardware_concurrency();
+
+    auto clock = std::chrono::steady_clock::now();
+    auto lap = [&](const std::string& phase){
+        auto now = std::chrono::steady_clock::now();
+        std::cout << phase << ": " << std::chrono::duration<double>(now - clock).count() << " s" << std::endl;
+        clock = now;
+    };
+
+    PbfFile pbf(inputPath);
+    size_t blobCount = pbf.Blobs().size();
+    WorkStealingPool pool(threads);
+    std::vector<Scratch> scratch(pool.Size());
+
+    // Pass 1: drivable ways, remembering which blocks carry nodes
+    std::vector<WayBatch> ways(blobCount);
+    std::vector<uint8_t> hasNodes(blobCount, 0);
+    pool.ParallelFor(blobCount, 1, [&](size_t i, size_t worker){
+        Scratch& s = scratch[worker];
+        pbf.Read(i, s.raw, s.data);
+        PrimitiveBlock block({reinterpret_cast<const char*>(s.data.data()), s.data.size()});
+        hasNodes[i] = block.HasNodes();
+        if (!block.HasWays()) return;
+
+        WayBatch& batch = ways[i];
+        block.ForEachWay([&](int64_t, const std::vector<OsmTag>& tags, const std::vector<int64_t>& refs){
+            // A closed way needs three distinct points to be a loop
+            bool closed = refs.size() >= 2 && refs.front() == refs.back();
+            Direction direction;
+            if (refs.size() < (closed ? 4 : 2) || !drivable(tags, direction)) return;
+            batch.refs.insert(batch.refs.end(), refs.begin(), refs.end());
+            batch.offsets.push_back(static_cast<uint32_t>(batch.refs.size()));
+            batch.directions.push_back(direction);
+        });
+    });
+    lap("Ways");
+
+    // Number every referenced node; way ends and nodes used twice are junctions
+    FlatIdMap index;
+    std::vector<uint8_t> uses;
+    for (const WayBatch& batch: ways) {
+        for (size_t w = 0; w + 1 < batch.offsets.size(); w++) {
+            for (uint32_t r = batch.offsets[w]; r < batch.offsets[w + 1]; r++) {
+                uint32_t v;
+                if (!index.Find(batch.refs[r], v)) {
+                    v = static_cast<uint32_t>(uses.size());
+                    index.Insert(batch.refs[r], v);
+                    uses.push_back(0);
+                }
+                bool end = r == batch.offsets[w] || r + 1 == batch.offsets[w + 1];
+                uses[v] = end ? 2 : std::min<uint8_t>(2, uses[v] + 1);
+            }
+
+            // A closed way split only at its ends would collapse into a
+            // self-loop, so its middle ref is a junction too
+            uint32_t first = batch.offsets[w], last = batch.offsets[w + 1] - 1;
+            if (batch.refs[first] == batch.refs[last]) uses[index.At(batch.refs[(first + last) / 2])] = 2;
+        }
+    }
+    lap("Node index");
+
+    // Pass 2: coordinates of the referenced nodes (ids are unique, so no two
+    // threads write the same slot)
+    std::vector<double> lat(uses.size(), std::nan("")), lon(uses.size(), std::nan(""));
+    pool.ParallelFor(blobCount, 1, [&](size_t i, size_t worker){
+        if (!hasNodes[i]) return;
+        Scratch& s = scratch[worker];
+        pbf.Read(i, s.raw, s.data);
+        PrimitiveBlock block({reinterpret_cast<const char*>(s.data.data()), s.data.size()});
+        block.ForEachNode([&](int64_t id, double nodeLat, double nodeLon){
+            uint32_t v;
+            if (!index.Find(static_cast<uint64_t>(id), v)) return;
+            lat[v] = nodeLat;
+            lon[v] = nodeLon;
+        });
+    });
+    lap("Coordinates");
+
+    // Pass 3: split ways at junctions into edges. Refs outside the extract
+    // have no coordinates and cut the way there.
+    std::vector<EdgeBatch> edges(blobCount);
+    pool.ParallelFor(blobCount, 1, [&](size_t i, size_t){
+        const WayBatch& batch = ways[i];
+        EdgeBatch& out = edges[i];
+        auto emit = [&](uint32_t a, uint32_t b, double length, Direction direction){
+            if (a == b) return; // Repeated ref
+            if (direction != Direction::Backward) {
+                out.from.push_back(a); out.to.push_back(b); out.weight.push_back(length);
+            }
+            if (direction != Direction::Forward) {
+                out.from.push_back(b); out.to.push_back(a); out.weight.push_back(length);
+            }
+        };
+
+        for (size_t w = 0; w + 1 < batch.offsets.size(); w++) {
+            uint32_t start = std::numeric_limits<uint32_t>::max(), previous = start;
+            double length = 0;
+            for (uint32_t r = batch.offsets[w]; r < batch.offsets[w + 1]; r++) {
+                uint32_t v = index.At(batch.refs[r]);
+                if (std::isnan(lat[v])) {
+                    start = previous = std::numeric_limits<uint32_t>::max();
+                    continue;
+                }
+                if (previous == std::numeric_limits<uint32_t>::max()) {
+                    start = previous = v;
+                    length = 0;
+                    continue;
+                }
+
+                length += haversine(lat[previous], lon[previous], lat[v], lon[v]);
+                previous = v;
+                if (uses[v] >= 2 || r + 1 == batch.offsets[w + 1] || std::isnan(lat[index.At(batch.refs[r + 1])])) {
+                    emit(start, v, length, batch.directions[w]);
+                    start = v;
+                    length = 0;
+                }
+            }
+        }
+    });
+    lap("Edges");
+
+    // Keep only nodes that ended up on an edge, in first-use order
+    GraphFile graph;
+    std::vector<uint32_t> remap(uses.size(), std::numeric_limits<uint32_t>::max());
+    auto keep = [&](uint32_t v){
+        if (remap[v] == std::numeric_limits<uint32_t>::max()) {
+            remap[v] = static_cast<uint32_t>(graph.ids.size());
+            graph.lat.push_back(lat[v]);
+            graph.lon.push_back(lon[v]);
+            graph.ids.push_back(0);
+        }
+        return remap[v];
+    };
+    for (const EdgeBatch& batch: edges) {
+        for (size_t e = 0; e < batch.from.size(); e++) {
+            graph.from.push_back(keep(batch.from[e]));
+            graph.to.push_back(keep(batch.to[e]));
+            graph.weight.push_back(batch.weight[e]);
+        }
+    }
+    for (const WayBatch& batch: ways) {
+        for (uint64_t id: batch.refs) {
+            uint32_t v = index.At(id);
+            if (remap[v] != std::numeric_limits<uint32_t>::max()) graph.ids[remap[v]] = id;
+        }
+    }
+
+    if (graph.ids.empty()) {
+        std::cerr << "No drivable roads found in " << inputPath << std::endl;
+        return 1;
+    }
+
+    WriteGraphFile(outputDir + "/map_graph.bin", graph);
+
+    json bounds;
+    bounds["lat_min"] = *std::min_element(graph.lat.begin(), graph.lat.end());
+    bounds["lat_max"] = *std::max_element(graph.lat.begin(), graph.lat.end());
+    bounds["lon_min"] = *std::min_element(graph.lon.begin(), graph.lon.end());
+    bounds["lon_max"] = *std::max_element(graph.lon.begin(), graph.lon.end());
+    std::ofstream f(outputDir + "/map_bounds.json");
+    f << bounds.dump(2);
+    lap("Write");
+
+    std::cout << blobCount << " blocks, " << graph.ids.size() << " nodes, "
+              << graph.from.size() << " edges written to " << outputDir << std::endl;
+    return 0;
+}
@@ -0,0 +1,461 @@
+#ifndef OVERLAY_GRAPH_HPP
+#define OVERLAY_GRAPH_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "csr_graph.hpp"
+#include "partition.hpp"
+#include "query_arena.hpp"
+#include "work_stealing_pool.hpp"
+
+// Multi-level overlay routing (Delling et al., CRP). The graph is split into
+// nested cells; a node is a boundary node of a level if an edge joins it to
+// another cell of that level. For every cell an OverlayMetric stores a
+// clique: the shortest distance inside the cell between every pair of its
+// boundary nodes. A query then searches the base graph only in the lowest
+// level cells of the source and target, and elsewhere hops across cells on
+// the cliques of the highest level that separates it from both.
+//
+// OverlayGraph holds the metric-independent part (partition, boundary
+// nodes, clique layout). Cells are self-contained units of bounded size, so
+// they also serve as tiles for loading large maps piecewise. Nodes are
+// CsrGraph indices; partition level k is overlay level k.
+class OverlayGraph {
+    public:
+    static constexpr uint32_t NoIndex = std::numeric_limits<uint32_t>::max();
+
+    private:
+    struct Level {
+        std::vector<uint32_t> boundaryOffsets; // Cell -> first of its boundary nodes
+        std::vector<uint32_t> boundary;        // Boundary nodes grouped by cell
+        std::vector<uint32_t> index;           // Node -> position among its cell's boundary nodes
+        std::vector<size_t> cliqueOffsets;     // Cell -> first entry of its row-major clique
+    };
+
+    const CsrGraph& m_Graph;
+    MultiLevelPartition m_Partition;
+    std::vector<Level> m_Levels;
+    std::vector<uint32_t> m_InOffsets, m_InEdges; // In-edges (CsrGraph edge ids) grouped by target
+    std::vector<uint32_t> m_Sources;              // Edge -> the node it leaves
+
+    public:
+    OverlayGraph(const CsrGraph& graph, MultiLevelPartition partition)
+        : m_Graph(graph), m_Partition(std::move(partition))
+    {
+        for (const auto& cells: m_Partition.cell) {
+            if (cells.size() != graph.NodeCount()) throw std::runtime_error("Partition does not match the graph\n");
+        }
+        for (uint32_t k = 0; k < LevelCount(); k++) buildLevel(k);
+        buildInEdges();
+    }
+
+    // Cells of at most 128, 2048 and 32768 nodes by default; the pool only
+    // speeds up partitioning
+    explicit OverlayGraph(const CsrGraph& graph, const std::vector<uint32_t>& maxCellSizes = {128, 2048, 32768},
+                          WorkStealingPool* pool = nullptr)
+        : OverlayGraph(graph, RecursivePartition(UndirectedGraph(graph), maxCellSizes, pool)) {}
+
+    inline const CsrGraph& Graph() const { return m_Graph; }
+    inline const MultiLevelPartition& Partition() const { return m_Partition; }
+    inline uint32_t LevelCount() const { return m_Partition.LevelCount(); }
+    inline uint32_t CellCount(uint32_t k) const { return m_Partition.cellCount[k]; }
+    inline uint32_t Cell(uint32_t k, uint32_t v) const { return m_Partition.cell[k][v]; }
+
+    inline uint32_t BoundaryBegin(uint32_t k, uint32_t cell) const { return m_Levels[k].boundaryOffsets[cell]; }
+    inline uint32_t BoundaryEnd(uint32_t k, uint32_t cell) const { return m_Levels[k].boundaryOffsets[cell + 1]; }
+    inline uint32_t BoundaryNode(uint32_t k, uint32_t i) const { return m_Levels[k].boundary[i]; }
+    inline uint32_t BoundaryIndex(uint32_t k, uint32_t v) const { return m_Levels[k].index[v]; }
+    inline uint32_t BoundaryCount(uint32_t k) const { return static_cast<uint32_t>(m_Levels[k].boundary.size()); }
+
+    inline size_t CliqueOffset(uint32_t k, uint32_t cell) const { return m_Levels[k].cliqueOffsets[cell]; }
+    inline size_t CliqueEntries(uint32_t k) const { return m_Levels[k].cliqueOffsets.back(); }
+
+    // Edges into v, for searches that run backward from a target
+    inline uint32_t InBegin(uint32_t v) const { return m_InOffsets[v]; }
+    inline uint32_t InEnd(uint32_t v) const { return m_InOffsets[v + 1]; }
+    inline uint32_t InEdge(uint32_t i) const { return m_InEdges[i]; }
+    inline uint32_t Source(uint32_t e) const { return m_Sources[e]; }
+
+    // Highest level whose cell of v holds neither s nor t, or -1 if v shares
+    // a lowest level cell with one of them. Cells nest, so a level that
+    // separates v from both is the only test needed, from the top down.
+    inline int QueryLevel(uint32_t v, uint32_t s, uint32_t t) const {
+        for (int k = static_cast<int>(LevelCount()) - 1; k >= 0; k--) {
+            const auto& cell = m_Partition.cell[k];
+            if (cell[v] != cell[s] && cell[v] != cell[t]) return k;
+        }
+        return -1;
+    }
+
+    private:
+    void buildLevel(uint32_t k) {
+        uint32_t n = m_Graph.NodeCount(), cells = CellCount(k);
+        const auto& cell = m_Partition.cell[k];
+        std::vector<uint8_t> isBoundary(n, 0);
+        for (uint32_t u = 0; u < n; u++) {
+            for (uint32_t e = m_Graph.Begin(u); e < m_Graph.End(u); e++) {
+                uint32_t v = m_Graph.Target(e);
+                if (cell[u] != cell[v]) isBoundary[u] = isBoundary[v] = 1;
+            }
+        }
+
+        Level level;
+        level.boundaryOffsets.assign(cells + 1, 0);
+        for (uint32_t v = 0; v < n; v++) {
+            if (isBoundary[v]) level.boundaryOffsets[cell[v] + 1]++;
+        }
+        for (uint32_t c = 0; c < cells; c++) level.boundaryOffsets[c + 1] += level.boundaryOffsets[c];
+
+        level.boundary.resize(level.boundaryOffsets.back());
+        level.index.assign(n, NoIndex);
+        std::vector<uint32_t> fill(level.boundaryOffsets.begin(), level.boundaryOffsets.end() - 1);
+        for (uint32_t v = 0; v < n; v++) {
+            if (!isBoundary[v]) continue;
+            level.index[v] = fill[cell[v]] - level.boundaryOffsets[cell[v]];
+            level.boundary[fill[cell[v]]++] = v;
+        }
+
+        level.cliqueOffsets.assign(cells + 1, 0);
+        for (uint32_t c = 0; c < cells; c++) {
+            size_t size = level.boundaryOffsets[c + 1] - level.boundaryOffsets[c];
+            level.cliqueOffsets[c + 1] = level.cliqueOffsets[c] + size * size;
+        }
+        m_Levels.push_back(std::move(level));
+    }
+
+    void buildInEdges() {
+        uint32_t n = m_Graph.NodeCount();
+        m_Sources.resize(m_Graph.EdgeCount());
+        m_InOffsets.assign(n + 1, 0);
+        for (uint32_t u = 0; u < n; u++) {
+            for (uint32_t e = m_Graph.Begin(u); e < m_Graph.End(u); e++) {
+                m_Sources[e] = u;
+                m_InOffsets[m_Graph.Target(e) + 1]++;
+            }
+        }
+        for (uint32_t v = 0; v < n; v++) m_InOffsets[v + 1] += m_InOffsets[v];
+
+        m_InEdges.resize(m_Graph.EdgeCount());
+        std::vector<uint32_t> fill(m_InOffsets.begin(), m_InOffsets.end() - 1);
+        for (uint32_t e = 0; e < m_Graph.EdgeCount(); e++) m_InEdges[fill[m_Graph.Target(e)]++] = e;
+    }
+};
+
+
+// Dijkstra confined to one cell, reused across searches. At level 0 it runs
+// on the base graph; at level k > 0 on the overlay of level k - 1 inside the
+// cell: boundary nodes joined by their level k - 1 cliques and by the base
+// edges between level k - 1 cells.
+class CellSearch {
+    private:
+    const OverlayGraph& m_Overlay;
+    std::vector<double> m_Dist;
+    std::vector<uint32_t> m_Touched;
+
+    public:
+    explicit CellSearch(const OverlayGraph& overlay)
+        : m_Overlay(overlay), m_Dist(overlay.Graph().NodeCount(), std::numeric_limits<double>::infinity()) {}
+
+    inline double Distance(uint32_t v) const { return m_Dist[v]; }
+
+    // Distances from source within cell `cell` of level k; read with Distance()
+    template<typename Clique>
+    void Run(uint32_t k, uint32_t cell, uint32_t source, const std::vector<double>& weights, Clique&& clique) {
+        const CsrGraph& graph = m_Overlay.Graph();
+        for (uint32_t v: m_Touched) m_Dist[v] = std::numeric_limits<double>::infinity();
+        m_Touched.clear();
+
+        QueryArena::Scope scratch;
+        auto pq = scratch.Heap<double>();
+        m_Dist[source] = 0;
+        m_Touched.push_back(source);
+        pq.emplace(0, source);
+
+        auto relax = [&](uint32_t v, double alt){
+            if (alt < m_Dist[v]) {
+                if (m_Dist[v] == std::numeric_limits<double>::infinity()) m_Touched.push_back(v);
+                m_Dist[v] = alt;
+                pq.emplace(alt, v);
+            }
+        };
+
+        while (!pq.empty()) {
+            auto [cost, u] = pq.top(); pq.pop();
+            if (cost > m_Dist[u]) continue;
+
+            for (uint32_t e = graph.Begin(u); e < graph.End(u); e++) {
+                uint32_t v = graph.Target(e);
+                if (m_Overlay.Cell(k, v) != cell) continue;
+                if (k > 0 && m_Overlay.Cell(k - 1, v) == m_Overlay.Cell(k - 1, u)) continue; // Covered by the clique
+                relax(v, cost + weights[e]);
+            }
+            if (k > 0) {
+                uint32_t sub = m_Overlay.Cell(k - 1, u);
+                uint32_t first = m_Overlay.BoundaryBegin(k - 1, sub), count = m_Overlay.BoundaryEnd(k - 1, sub) - first;
+                size_t row = m_Overlay.CliqueOffset(k - 1, sub) + static_cast<size_t>(m_Overlay.BoundaryIndex(k - 1, u)) * count;
+                for (uint32_t j = 0; j < count; j++) relax(m_Overlay.BoundaryNode(k - 1, first + j), cost + clique(k - 1, row + j));
+            }
+        }
+    }
+};
+
+
+// Cliques of every cell for one weight array (one value per CsrGraph edge),
+// built bottom-up: level 0 cliques by Dijkstra on the base graph inside each
+// cell, higher levels on the overlay of the level below. Cells of a level
+// are independent and spread over the pool. Immutable once built, like
+// CchMetric: build a new one to apply new weights.
+class OverlayMetric {
+    private:
+    const OverlayGraph& m_Overlay;
+    std::vector<double> m_Weights;
+    std::vector<std::vector<double>> m_Cliques; // Per level
+
+    public:
+    OverlayMetric(const OverlayGraph& overlay, const std::vector<double>& weights, WorkStealingPool* pool = nullptr)
+        : m_Overlay(overlay), m_Weights(weights)
+    {
+        if (m_Weights.size() != overlay.Graph().EdgeCount()) {
+            throw std::runtime_error("Weight array does not match the graph\n");
+        }
+
+        size_t workers = pool ? pool->Size() : 1;
+        std::vector<std::unique_ptr<CellSearch>> searches;
+        for (size_t w = 0; w < workers; w++) searches.push_back(std::make_unique<CellSearch>(overlay));
+
+        m_Cliques.resize(overlay.LevelCount());
+        for (uint32_t k = 0; k < overlay.LevelCount(); k++) {
+            m_Cliques[k].assign(overlay.CliqueEntries(k), std::numeric_limits<double>::infinity());
+            auto customize = [&](size_t cell, size_t worker){ customizeCell(k, static_cast<uint32_t>(cell), *searches[worker]); };
+            if (pool) {
+                pool->ParallelFor(overlay.CellCount(k), 1, customize);
+            } else {
+                for (uint32_t c = 0; c < overlay.CellCount(k); c++) customize(c, 0);
+            }
+        }
+    }
+
+    // Metric for the graph's own weights
+    explicit OverlayMetric(const OverlayGraph& overlay, WorkStealingPool* pool = nullptr)
+        : OverlayMetric(overlay, edgeWeights(overlay.Graph()), pool) {}
+
+    inline const OverlayGraph& Overlay() const { return m_Overlay; }
+    inline double Weight(uint32_t e) const { return m_Weights[e]; }
+    inline const std::vector<double>& Weights() const { return m_Weights; }
+    inline double Clique(uint32_t k, size_t entry) const { return m_Cliques[k][entry]; }
+
+    private:
+    static std::vector<double> edgeWeights(const CsrGraph& graph) {
+        std::vector<double> weights(graph.EdgeCount());
+        for (uint32_t e = 0; e < graph.EdgeCount(); e++) weights[e] = graph.Weight(e);
+        return weights;
+    }
+
+    void customizeCell(uint32_t k, uint32_t cell, CellSearch& search) {
+        uint32_t first = m_Overlay.BoundaryBegin(k, cell), count = m_Overlay.BoundaryEnd(k, cell) - first;
+        double* clique = m_Cliques[k].data() + m_Overlay.CliqueOffset(k, cell);
+        for (uint32_t i = 0; i < count; i++) {
+            search.Run(k, cell, m_Overlay.BoundaryNode(k, first + i), m_Weights,
+                       [&](uint32_t level, size_t entry){ return m_Cliques[level][entry]; });
+            for (uint32_t j = 0; j < count; j++) clique[static_cast<size_t>(i) * count + j] = search.Distance(m_Overlay.BoundaryNode(k, first + j));
+        }
+    }
+};
+
+
+// Point-to-point query on an OverlayMetric, searching forward from the
+// source and backward from the target until the two meet. Each settled node
+// is expanded at its QueryLevel: on the base graph next to the source and
+// target, and elsewhere along its cell's clique plus the edges crossing that
+// cell's border. Clique hops in the result are unpacked by a base graph
+// search inside their cell. One per thread.
+class OverlayQuery {
+    private:
+    static constexpr uint32_t NoNode = std::numeric_limits<uint32_t>::max();
+    static constexpr int8_t BaseEdge = -1;
+
+    // One search direction. Backward, prev is the next node towards the target.
+    struct Side {
+        std::vector<double> dist;
+        std::vector<uint32_t> prev, touched;
+        std::vector<int8_t> via; // BaseEdge, or the level of the clique hop that reached the node
+        size_t settled = 0;
+
+        explicit Side(uint32_t n) : dist(n, std::numeric_limits<double>::infinity()), prev(n, NoNode), via(n, BaseEdge) {}
+    };
+
+    const OverlayGraph& m_Overlay;
+    const OverlayMetric* m_Metric = nullptr;
+    Side m_Forward, m_Backward;
+    uint32_t m_Meeting = NoNode;
+    double m_Distance = std::numeric_limits<double>::infinity();
+
+    public:
+    explicit OverlayQuery(const OverlayGraph& overlay)
+        : m_Overlay(overlay), m_Forward(overlay.Graph().NodeCount()), m_Backward(overlay.Graph().NodeCount()) {}
+
+    // CsrGraph node indices; infinity if the target cannot be reached
+    double Run(const OverlayMetric& metric, uint32_t source, uint32_t target) {
+        if (&metric.Overlay() != &m_Overlay) throw std::runtime_error("Metric belongs to another overlay\n");
+        const CsrGraph& graph = m_Overlay.Graph();
+        if (source >= graph.NodeCount() || target >= graph.NodeCount()) {
+            throw std::runtime_error("Start or end node not found in graph\n");
+        }
+        m_Metric = &metric;
+        m_Meeting = NoNode;
+        m_Distance = std::numeric_limits<double>::infinity();
+
+        QueryArena::Scope scratch;
+        ScratchHeap<double> queues[2] = {scratch.Heap<double>(), scratch.Heap<double>()};
+        Side* sides[2] = {&m_Forward, &m_Backward};
+        for (int d = 0; d < 2; d++) {
+            Side& side = *sides[d];
+            for (uint32_t v: side.touched) {
+                side.dist[v] = std::numeric_limits<double>::infinity();
+                side.prev[v] = NoNode;
+            }
+            side.touched.clear();
+            side.settled = 0;
+
+            uint32_t start = d == 0 ? source : target;
+            side.dist[start] = 0;
+            side.via[start] = BaseEdge;
+            side.touched.push_back(start);
+            queues[d].emplace(0, start);
+        }
+
+        // A path through v, seen from either side
+        auto meet = [&](uint32_t v){
+            double total = m_Forward.dist[v] + m_Backward.dist[v];
+            if (total < m_Distance) {
+                m_Distance = total;
+                m_Meeting = v;
+            }
+        };
+        auto top = [&](int d){
+            return queues[d].empty() ? std::numeric_limits<double>::infinity() : queues[d].top().first;
+        };
+
+        while (top(0) + top(1) < m_Distance) {
+            int d = top(0) <= top(1) ? 0 : 1;
+            Side& side = *sides[d];
+            double cost = queues[d].top().first;
+            uint32_t u = queues[d].top().second;
+            queues[d].pop();
+            if (cost > side.dist[u]) continue;
+            side.settled++;
+            meet(u);
+
+            auto relax = [&](uint32_t v, double alt, int8_t via){
+                if (alt < side.dist[v]) {
+                    if (side.dist[v] == std::numeric_limits<double>::infinity()) side.touched.push_back(v);
+                    side.dist[v] = alt;
+                    side.prev[v] = u;
+                    side.via[v] = via;
+                    queues[d].emplace(alt, v);
+                    meet(v);
+                }
+            };
+
+            // The same arcs either way: both ends of a skipped edge share the cell
+            int level = m_Overlay.QueryLevel(u, source, target);
+            bool inside = level >= 0;
+            if (d == 0) {
+                for (uint32_t e = graph.Begin(u); e < graph.End(u); e++) {
+                    uint32_t v = graph.Target(e);
+                    if (inside && m_Overlay.Cell(level, v) == m_Overlay.Cell(level, u)) continue; // Inside: the clique covers it
+                    relax(v, cost + metric.Weight(e), BaseEdge);
+                }
+            } else {
+                for (uint32_t i = m_Overlay.InBegin(u); i < m_Overlay.InEnd(u); i++) {
+                    uint32_t e = m_Overlay.InEdge(i), v = m_Overlay.Source(e);
+                    if (inside && m_Overlay.Cell(level, v) == m_Overlay.Cell(level, u)) continue;
+                    relax(v, cost + metric.Weight(e), BaseEdge);
+                }
+            }
+            // Reached by a hop along this cell's clique: by the triangle
+            // inequality the row cannot improve anything, only the cut edges
+            if (inside && side.via[u] != level) {
+                // Reached across the cell border, so u is one of its boundary nodes.
+                // Forward reads u's clique row, backward its column.
+                uint32_t k = static_cast<uint32_t>(level), cell = m_Overlay.Cell(k, u);
+                uint32_t first = m_Overlay.BoundaryBegin(k, cell), count = m_Overlay.BoundaryEnd(k, cell) - first;
+                size_t clique = m_Overlay.CliqueOffset(k, cell), index = m_Overlay.BoundaryIndex(k, u);
+                for (uint32_t j = 0; j < count; j++) {
+                    size_t entry = d == 0 ? clique + index * count + j : clique + static_cast<size_t>(j) * count + index;
+                    relax(m_Overlay.BoundaryNode(k, first + j), cost + metric.Clique(k, entry), static_cast<int8_t>(k));
+                }
+            }
+        }
+        return m_Distance;
+    }
+
+    inline size_t Settled() const { return m_Forward.settled + m_Backward.settled; }
+
+    // Path of the last Run() as CsrGraph node indices; empty if unreachable.
+    // The metric must still be alive.
+    std::vector<uint32_t> Path() const {
+        std::vector<uint32_t> path;
+        if (m_Meeting == NoNode) return path;
+
+        std::vector<uint32_t> hops; // Meeting node back to the source
+        for (uint32_t v = m_Meeting; v != NoNode; v = m_Forward.prev[v]) hops.push_back(v);
+        std::reverse(hops.begin(), hops.end());
+
+        path.push_back(hops[0]);
+        for (size_t i = 1; i < hops.size(); i++) {
+            uint32_t v = hops[i];
+            if (m_Forward.via[v] == BaseEdge) path.push_back(v);
+            else unpack(static_cast<uint32_t>(m_Forward.via[v]), hops[i - 1], v, path);
+        }
+        // On to the target along the backward search's tree
+        for (uint32_t v = m_Meeting; m_Backward.prev[v] != NoNode; v = m_Backward.prev[v]) {
+            uint32_t next = m_Backward.prev[v];
+            if (m_Backward.via[v] == BaseEdge) path.push_back(next);
+            else unpack(static_cast<uint32_t>(m_Backward.via[v]), v, next, path);
+        }
+        return path;
+    }
+
+    private:
+    // Shortest base graph path from a to b inside their level-k cell, appended without a
+    void unpack(uint32_t k, uint32_t a, uint32_t b, std::vector<uint32_t>& path) const {
+        const CsrGraph& graph = m_Overlay.Graph();
+        uint32_t cell = m_Overlay.Cell(k, a);
+
+        QueryArena::Scope scratch;
+        std::pmr::unordered_map<uint32_t, std::pair<double, uint32_t>> reached(scratch.Resource()); // Node -> {dist, prev}
+        auto pq = scratch.Heap<double>();
+        reached[a] = {0, NoNode};
+        pq.emplace(0, a);
+        while (!pq.empty()) {
+            auto [cost, u] = pq.top(); pq.pop();
+            if (cost > reached[u].first) continue;
+            if (u == b) break;
+            for (uint32_t e = graph.Begin(u); e < graph.End(u); e++) {
+                uint32_t v = graph.Target(e);
+                if (m_Overlay.Cell(k, v) != cell) continue;
+                double alt = cost + m_Metric->Weight(e);
+                auto it = reached.find(v);
+                if (it == reached.end() || alt < it->second.first) {
+                    reached[v] = {alt, u};
+                    pq.emplace(alt, v);
+                }
+            }
+        }
+        if (reached.find(b) == reached.end()) throw std::runtime_error("Overlay hop could not be unpacked\n");
+
+        size_t end = path.size();
+        for (uint32_t v = b; v != a; v = reached[v].second) path.push_back(v);
+        std::reverse(path.begin() + end, path.end());
+    }
+};
+
+#endif
@@ -0,0 +1,530 @@
+#ifndef PARTITION_HPP
+#define PARTITION_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "graph_traits.hpp"
+#include "work_stealing_pool.hpp"
+
+// Undirected view of a graph for partitioning: both arc directions merged,
+// no loops or duplicate edges, plus planar node coordinates (only
+// directions matter, so degrees with longitude scaled by cos(latitude)).
+// Built from a Graph or a CsrGraph; node indices are that graph's.
+class UndirectedGraph {
+    private:
+    std::vector<uint32_t> m_Offsets, m_Targets;
+    std::vector<double> m_X, m_Y;
+
+    public:
+    template<typename GraphT>
+    explicit UndirectedGraph(const GraphT& graph) {
+        using Traits = GraphTraits<GraphT>;
+        uint32_t n = Traits::NodeCount(graph);
+        std::vector<std::vector<uint32_t>> adjacency(n);
+        double meanLat = 0;
+        for (uint32_t u = 0; u < n; u++) {
+            meanLat += Traits::Lat(graph, u) / n;
+            Traits::template ForEachEdge<double>(graph, u, [&](uint32_t v, double){
+                if (u == v) return;
+                adjacency[u].push_back(v);
+                adjacency[v].push_back(u);
+            });
+        }
+
+        double scale = std::cos(meanLat * M_PI / 180.0);
+        m_Offsets.assign(n + 1, 0);
+        for (uint32_t u = 0; u < n; u++) {
+            auto& list = adjacency[u];
+            std::sort(list.begin(), list.end());
+            list.erase(std::unique(list.begin(), list.end()), list.end());
+            m_Offsets[u + 1] = m_Offsets[u] + static_cast<uint32_t>(list.size());
+            m_Targets.insert(m_Targets.end(), list.begin(), list.end());
+            m_X.push_back(Traits::Lon(graph, u) * scale);
+            m_Y.push_back(Traits::Lat(graph, u));
+        }
+    }
+
+    inline uint32_t NodeCount() const { return static_cast<uint32_t>(m_X.size()); }
+    inline uint32_t EdgeCount() const { return static_cast<uint32_t>(m_Targets.size() / 2); }
+    inline uint32_t Begin(uint32_t v) const { return m_Offsets[v]; }
+    inline uint32_t End(uint32_t v) const { return m_Offsets[v + 1]; }
+    inline uint32_t Target(uint32_t e) const { return m_Targets[e]; }
+    inline double X(uint32_t v) const { return m_X[v]; }
+    inline double Y(uint32_t v) const { return m_Y[v]; }
+};
+
+// Inertial flow bisection (Schild and Sommer): the nodes are sorted along a
+// direction, the first and last `balance` share of them are tied to a
+// source and a sink, and a minimum edge cut between the two is found by
+// unit-capacity max flow. Of four directions (east, north and both
+// diagonals) the smallest cut wins, ties going to the more even split and
+// then to the earlier direction. Either side keeps at least the `balance`
+// share. Holds per-node scratch, so one per thread.
+class InertialFlow {
+    public:
+    static constexpr size_t DirectionCount = 4;
+
+    // Edges cut and how far the sides are from even, in nodes
+    struct Cut {
+        size_t edges = SIZE_MAX, skew = SIZE_MAX;
+
+        inline bool Beats(const Cut& other) const {
+            return edges < other.edges || (edges == other.edges && skew < other.skew);
+        }
+    };
+
+    private:
+    static constexpr uint32_t NoIndex = std::numeric_limits<uint32_t>::max();
+    enum Role : uint8_t { Free, Source, Sink };
+
+    const UndirectedGraph& m_Graph;
+    double m_Balance;
+    std::vector<uint32_t> m_Local; // Node -> index in the current set, NoIndex outside
+
+    // Current set as a local graph; an edge is two arcs with capacity one
+    // each and skew-symmetric flow
+    std::vector<uint32_t> m_Offsets, m_Heads, m_Reverse;
+    std::vector<int8_t> m_Flow;
+    std::vector<uint8_t> m_Role;
+    std::vector<uint32_t> m_Level, m_Current, m_Queue, m_Path; // Dinic layers and walk
+    std::vector<uint32_t> m_Seen;                              // m_Stamp if reached by the last layering
+    uint32_t m_Stamp = 0;
+    std::vector<std::pair<double, uint32_t>> m_Sorted;
+
+    public:
+    explicit InertialFlow(const UndirectedGraph& graph, double balance = 0.25)
+        : m_Graph(graph), m_Balance(balance), m_Local(graph.NodeCount(), NoIndex) {}
+
+    // Splits `nodes` (at least two) into `left` and `right`; returns the
+    // number of edges cut
+    size_t Bisect(const std::vector<uint32_t>& nodes, std::vector<uint32_t>& left, std::vector<uint32_t>& right) {
+        buildLocal(nodes);
+        Cut best;
+        for (size_t d = 0; d < DirectionCount; d++) {
+            // A direction is dropped once its flow exceeds the best cut
+            Cut cut = cutAlong(nodes, d, best.edges);
+            if (!cut.Beats(best)) continue;
+            best = cut;
+            split(nodes, left, right);
+        }
+        for (uint32_t v: nodes) m_Local[v] = NoIndex;
+        return best.edges;
+    }
+
+    // One direction of Bisect(), so that the directions can run on
+    // separate threads. Gives up once the flow exceeds `limit`, leaving
+    // `left` and `right` alone; Bisect() is the first direction no other
+    // one Beats().
+    Cut Trial(const std::vector<uint32_t>& nodes, size_t direction, size_t limit,
+              std::vector<uint32_t>& left, std::vector<uint32_t>& right) {
+        buildLocal(nodes);
+        Cut cut = cutAlong(nodes, direction, limit);
+        if (cut.edges <= limit) split(nodes, left, right);
+        for (uint32_t v: nodes) m_Local[v] = NoIndex;
+        return cut;
+    }
+
+    private:
+    void buildLocal(const std::vector<uint32_t>& nodes) {
+        uint32_t n = static_cast<uint32_t>(nodes.size());
+        for (uint32_t i = 0; i < n; i++) m_Local[nodes[i]] = i;
+
+        m_Offsets.assign(n + 1, 0);
+        m_Heads.clear();
+        for (uint32_t i = 0; i < n; i++) {
+            uint32_t v = nodes[i];
+            for (uint32_t e = m_Graph.Begin(v); e < m_Graph.End(v); e++) {
+                uint32_t head = m_Local[m_Graph.Target(e)];
+                if (head != NoIndex) m_Heads.push_back(head);
+            }
+            m_Offsets[i + 1] = static_cast<uint32_t>(m_Heads.size());
+            std::sort(m_Heads.begin() + m_Offsets[i], m_Heads.end());
+        }
+
+        // Adjacency is symmetric and sorted, so walking the nodes in order
+        // meets the arcs j -> i (i < j) in the order they are stored
+        m_Reverse.assign(m_Heads.size(), NoIndex);
+        std::vector<uint32_t> cursor(m_Offsets.begin(), m_Offsets.end() - 1);
+        for (uint32_t i = 0; i < n; i++) {
+            for (uint32_t a = m_Offsets[i]; a < m_Offsets[i + 1]; a++) {
+                uint32_t j = m_Heads[a];
+                if (j <= i) continue;
+                while (m_Heads[cursor[j]] != i) cursor[j]++;
+                m_Reverse[a] = cursor[j];
+                m_Reverse[cursor[j]++] = a;
+            }
+        }
+
+        m_Flow.resize(m_Heads.size());
+        m_Role.resize(n);
+        m_Level.resize(n);
+        m_Current.resize(n);
+        m_Seen.assign(n, 0);
+        m_Stamp = 0;
+    }
+
+    // Max flow between the two ends of the local set sorted along a
+    // direction; the skew is only filled in if the flow stayed within `limit`
+    Cut cutAlong(const std::vector<uint32_t>& nodes, size_t direction, size_t limit) {
+        static const double directions[DirectionCount][2] = {{1, 0}, {0, 1}, {1, 1}, {1, -1}};
+        size_t n = nodes.size();
+        size_t k = std::max<size_t>(1, static_cast<size_t>(n * m_Balance));
+        k = std::min(k, n / 2);
+
+        m_Sorted.resize(n);
+        for (uint32_t i = 0; i < n; i++) {
+            uint32_t v = nodes[i];
+            m_Sorted[i] = {m_Graph.X(v) * directions[direction][0] + m_Graph.Y(v) * directions[direction][1], i};
+        }
+        std::nth_element(m_Sorted.begin(), m_Sorted.begin() + k, m_Sorted.end());
+        std::nth_element(m_Sorted.begin() + k, m_Sorted.end() - k, m_Sorted.end());
+        std::fill(m_Role.begin(), m_Role.end(), Free);
+        for (size_t i = 0; i < k; i++) {
+            m_Role[m_Sorted[i].second] = Source;
+            m_Role[m_Sorted[n - 1 - i].second] = Sink;
+        }
+
+        Cut cut;
+        cut.edges = maxFlow(limit);
+        if (cut.edges > limit) return cut;
+        size_t sourceSide = 0;
+        for (uint32_t i = 0; i < n; i++) sourceSide += m_Seen[i] == m_Stamp;
+        cut.skew = sourceSide * 2 > n ? sourceSide * 2 - n : n - sourceSide * 2;
+        return cut;
+    }
+
+    // Sides of the cut the last maxFlow() found
+    void split(const std::vector<uint32_t>& nodes, std::vector<uint32_t>& left, std::vector<uint32_t>& right) const {
+        left.clear();
+        right.clear();
+        for (uint32_t i = 0; i < nodes.size(); i++) (m_Seen[i] == m_Stamp ? left : right).push_back(nodes[i]);
+    }
+
+    // Dinic: layer the residual graph from the sources, saturate the
+    // layers with augmenting walks, repeat until no sink is reached or the
+    // flow exceeds `limit`. On return the nodes stamped m_Stamp are the
+    // source side of a minimum cut. Sources and sinks act as one node each,
+    // so arcs between two sources are never used.
+    size_t maxFlow(size_t limit) {
+        std::fill(m_Flow.begin(), m_Flow.end(), 0);
+        size_t flow = 0;
+        while (layer()) {
+            std::copy(m_Offsets.begin(), m_Offsets.end() - 1, m_Current.begin());
+            for (uint32_t s = 0; s < m_Role.size(); s++) {
+                if (m_Role[s] != Source) continue;
+                while (augment(s)) {
+                    if (++flow > limit) return flow;
+                }
+            }
+        }
+        return flow;
+    }
+
+    // Breadth-first search over arcs with residual capacity; true if a sink
+    // was reached
+    bool layer() {
+        m_Stamp++;
+        m_Queue.clear();
+        for (uint32_t i = 0; i < m_Role.size(); i++) {
+            if (m_Role[i] != Source) continue;
+            m_Seen[i] = m_Stamp;
+            m_Level[i] = 0;
+            m_Queue.push_back(i);
+        }
+        bool reached = false;
+        for (size_t q = 0; q < m_Queue.size(); q++) {
+            uint32_t u = m_Queue[q];
+            for (uint32_t a = m_Offsets[u]; a < m_Offsets[u + 1]; a++) {
+                uint32_t v = m_Heads[a];
+                if (m_Flow[a] >= 1 || m_Seen[v] == m_Stamp) continue;
+                m_Seen[v] = m_Stamp;
+                m_Level[v] = m_Level[u] + 1;
+                if (m_Role[v] == Sink) reached = true;
+                else m_Queue.push_back(v);
+            }
+        }
+        return reached;
+    }
+
+    // One walk from source s down the layers to a sink, pushing a unit of
+    // flow along it; nodes found to lead nowhere are taken out of the layers
+    bool augment(uint32_t s) {
+        m_Path.clear();
+        uint32_t u = s;
+        while (true) {
+            if (m_Role[u] == Sink) {
+                for (uint32_t a: m_Path) {
+                    m_Flow[a]++;
+                    m_Flow[m_Reverse[a]]--;
+                }
+                return true;
+            }
+            uint32_t& a = m_Current[u];
+            for (; a < m_Offsets[u + 1]; a++) {
+                uint32_t v = m_Heads[a];
+                if (m_Flow[a] < 1 && m_Seen[v] == m_Stamp && m_Role[v] != Source && m_Level[v] == m_Level[u] + 1) break;
+            }
+            if (a < m_Offsets[u + 1]) {
+                m_Path.push_back(a);
+                u = m_Heads[a];
+                continue;
+            }
+            m_Level[u] = NoIndex;
+            if (m_Path.empty()) return false;
+            u = m_Heads[m_Reverse[m_Path.back()]];
+            m_Path.pop_back();
+            m_Current[u]++;
+        }
+    }
+};
+
+// Bisects a batch of node sets at once over a pool: each set's four
+// directions are separate tasks, each on the worker's own InertialFlow.
+// The directions of one set share the best cut found so far as the limit
+// their flows give up at, and the winner is picked as in Bisect(), so the
+// halves do not depend on the thread count. Without a pool each set is
+// simply Bisect().
+class ParallelBisection {
+    private:
+    WorkStealingPool* m_Pool;
+    std::vector<std::unique_ptr<InertialFlow>> m_Flows; // Per worker
+
+    public:
+    explicit ParallelBisection(const UndirectedGraph& graph, WorkStealingPool* pool = nullptr) : m_Pool(pool) {
+        size_t workers = pool ? pool->Size() : 1;
+        for (size_t w = 0; w < workers; w++) m_Flows.push_back(std::make_unique<InertialFlow>(graph));
+    }
+
+    // Splits every *sets[i] (at least two nodes) into left[i] and right[i]
+    void Run(const std::vector<const std::vector<uint32_t>*>& sets,
+             std::vector<std::vector<uint32_t>>& left, std::vector<std::vector<uint32_t>>& right) {
+        left.resize(sets.size());
+        right.resize(sets.size());
+        if (!m_Pool) {
+            for (size_t i = 0; i < sets.size(); i++) m_Flows[0]->Bisect(*sets[i], left[i], right[i]);
+            return;
+        }
+
+        constexpr size_t D = InertialFlow::DirectionCount;
+        size_t tasks = sets.size() * D;
+        std::vector<InertialFlow::Cut> cuts(tasks);
+        std::vector<std::vector<uint32_t>> halves[2] = {std::vector<std::vector<uint32_t>>(tasks), std::vector<std::vector<uint32_t>>(tasks)};
+        std::unique_ptr<std::atomic<size_t>[]> best(new std::atomic<size_t>[sets.size()]);
+        for (size_t i = 0; i < sets.size(); i++) best[i].store(SIZE_MAX, std::memory_order_relaxed);
+
+        auto trial = [&](size_t task, size_t worker){
+            size_t i = task / D;
+            size_t limit = best[i].load(std::memory_order_relaxed);
+            cuts[task] = m_Flows[worker]->Trial(*sets[i], task % D, limit, halves[0][task], halves[1][task]);
+            while (cuts[task].edges < limit && !best[i].compare_exchange_weak(limit, cuts[task].edges, std::memory_order_relaxed)) {}
+        };
+        m_Pool->ParallelFor(tasks, 1, trial);
+
+        for (size_t i = 0; i < sets.size(); i++) {
+            size_t winner = i * D;
+            for (size_t task = i * D + 1; task < (i + 1) * D; task++) {
+                if (cuts[task].Beats(cuts[winner])) winner = task;
+            }
+            left[i] = std::move(halves[0][winner]);
+            right[i] = std::move(halves[1][winner]);
+        }
+    }
+};
+
+// Nested dissection order (lowest rank first) for metric-independent
+// contraction: each part is bisected, the endpoints of the cut edges on the
+// side with fewer of them become a separator, both remaining halves are
+// ordered recursively and the separator is ranked above them. Parts of at
+// most leafSize nodes are ranked as they come. The halves of a generation
+// are bisected together over the pool; the order does not depend on the
+// thread count.
+inline std::vector<uint32_t> NestedDissectionOrder(const UndirectedGraph& graph, size_t leafSize = 8,
+                                                   WorkStealingPool* pool = nullptr) {
+    static constexpr uint32_t NoPart = std::numeric_limits<uint32_t>::max();
+    uint32_t n = graph.NodeCount();
+    std::vector<uint8_t> side(n, 2);
+
+    // Dissection tree: a split part keeps its separator, a leaf its nodes
+    struct Part {
+        std::vector<uint32_t> nodes;
+        uint32_t halves[2] = {NoPart, NoPart};
+    };
+    std::vector<uint32_t> all(n);
+    for (uint32_t v = 0; v < n; v++) all[v] = v;
+    std::vector<Part> tree(1);
+    tree[0].nodes = std::move(all);
+
+    ParallelBisection bisection(graph, pool);
+    std::vector<uint32_t> generation = {0};
+    std::vector<std::vector<uint32_t>> left, right;
+    while (!generation.empty()) {
+        std::vector<uint32_t> split;
+        std::vector<const std::vector<uint32_t>*> sets;
+        for (uint32_t p: generation) {
+            if (tree[p].nodes.size() <= leafSize) continue;
+            split.push_back(p);
+            sets.push_back(&tree[p].nodes);
+        }
+        bisection.Run(sets, left, right);
+
+        std::vector<uint32_t> next;
+        for (size_t i = 0; i < split.size(); i++) {
+            uint32_t p = split[i];
+            for (uint32_t v: left[i]) side[v] = 0;
+            for (uint32_t v: right[i]) side[v] = 1;
+
+            // Boundary nodes of each side
+            std::vector<uint32_t> boundary[2];
+            for (const auto* half: {&left[i], &right[i]}) {
+                for (uint32_t v: *half) {
+                    for (uint32_t e = graph.Begin(v); e < graph.End(v); e++) {
+                        uint8_t other = side[graph.Target(e)];
+                        if (other != 2 && other != side[v]) {
+                            boundary[side[v]].push_back(v);
+                            break;
+                        }
+                    }
+                }
+            }
+            int cutSide = boundary[0].size() <= boundary[1].size() ? 0 : 1;
+            for (uint32_t v: boundary[cutSide]) side[v] = 3;
+
+            Part halves[2];
+            for (uint32_t v: tree[p].nodes) {
+                if (side[v] < 2) halves[side[v]].nodes.push_back(v);
+                side[v] = 2;
+            }
+            tree[p].nodes = std::move(boundary[cutSide]);
+            for (int h = 0; h < 2; h++) {
+                tree[p].halves[h] = static_cast<uint32_t>(tree.size());
+                next.push_back(tree[p].halves[h]);
+                tree.push_back(std::move(halves[h]));
+            }
+        }
+        generation = std::move(next);
+    }
+
+    // Both halves first, then the separator; a part is pushed again as
+    // {part, true} to emit it after its halves
+    std::vector<uint32_t> order;
+    order.reserve(n);
+    std::vector<std::pair<uint32_t, bool>> stack = {{0, false}};
+    while (!stack.empty()) {
+        auto [p, separator] = stack.back();
+        stack.pop_back();
+        const Part& part = tree[p];
+        if (separator || part.halves[0] == NoPart) {
+            order.insert(order.end(), part.nodes.begin(), part.nodes.end());
+            continue;
+        }
+        stack.emplace_back(p, true);
+        stack.emplace_back(part.halves[1], false);
+        stack.emplace_back(part.halves[0], false);
+    }
+    return order;
+}
+
+// Nested cells per level, finest first: nodes sharing a cell at level k
+// also share one at every level above k
+struct MultiLevelPartition {
+    std::vector<std::vector<uint32_t>> cell; // cell[level][node]
+    std::vector<uint32_t> cellCount;         // Per level
+
+    inline uint32_t LevelCount() const { return static_cast<uint32_t>(cell.size()); }
+};
+
+// Recursive bisection into cells of at most maxCellSizes[k] nodes at level k
+// (ascending sizes, finest level first): a part is split until it fits the
+// top level, becomes a cell there, and is split further for the next level
+// down. Parts are split a generation at a time, spread over the pool (see
+// ParallelBisection); cell ids follow the order of the parts and do not
+// depend on the thread count.
+inline MultiLevelPartition RecursivePartition(const UndirectedGraph& graph, const std::vector<uint32_t>& maxCellSizes,
+                                              WorkStealingPool* pool = nullptr) {
+    uint32_t n = graph.NodeCount();
+    uint32_t levels = static_cast<uint32_t>(maxCellSizes.size());
+    for (uint32_t k = 0; k < levels; k++) {
+        if (maxCellSizes[k] == 0 || (k > 0 && maxCellSizes[k] < maxCellSizes[k - 1])) {
+            throw std::runtime_error("Cell sizes must be positive and ascending\n");
+        }
+    }
+    MultiLevelPartition partition;
+    partition.cell.assign(levels, std::vector<uint32_t>(n, 0));
+    partition.cellCount.assign(levels, 0);
+    if (levels == 0 || n == 0) return partition;
+
+    struct Part {
+        std::vector<uint32_t> nodes;
+        uint32_t level;
+    };
+    std::vector<uint32_t> all(n);
+    for (uint32_t v = 0; v < n; v++) all[v] = v;
+    std::vector<Part> parts;
+    parts.push_back({std::move(all), levels - 1});
+
+    ParallelBisection bisection(graph, pool);
+    std::vector<std::vector<uint32_t>> left, right;
+    while (!parts.empty()) {
+        std::vector<const std::vector<uint32_t>*> sets;
+        for (const Part& part: parts) {
+            if (part.nodes.size() > maxCellSizes[part.level]) sets.push_back(&part.nodes);
+        }
+        bisection.Run(sets, left, right);
+
+        std::vector<Part> next;
+        size_t i = 0;
+        for (Part& part: parts) {
+            if (part.nodes.size() > maxCellSizes[part.level]) {
+                next.push_back({std::move(left[i]), part.level});
+                next.push_back({std::move(right[i]), part.level});
+                i++;
+                continue;
+            }
+            uint32_t id = partition.cellCount[part.level]++;
+            for (uint32_t v: part.nodes) partition.cell[part.level][v] = id;
+            if (part.level > 0) next.push_back({std::move(part.nodes), part.level - 1});
+        }
+        parts = std::move(next);
+    }
+    return partition;
+}
+
+// Per level: edges between cells and how far the largest cell is above the
+// mean (1 is perfectly even)
+struct PartitionQuality {
+    uint32_t cells = 0;
+    uint64_t cutEdges = 0;
+    uint32_t maxCellSize = 0;
+    double imbalance = 0;
+};
+
+inline std::vector<PartitionQuality> EvaluatePartition(const UndirectedGraph& graph, const MultiLevelPartition& partition) {
+    std::vector<PartitionQuality> quality(partition.LevelCount());
+    for (uint32_t k = 0; k < partition.LevelCount(); k++) {
+        const auto& cell = partition.cell[k];
+        PartitionQuality& level = quality[k];
+        level.cells = partition.cellCount[k];
+
+        std::vector<uint32_t> sizes(level.cells, 0);
+        for (uint32_t v = 0; v < graph.NodeCount(); v++) {
+            sizes[cell[v]]++;
+            for (uint32_t e = graph.Begin(v); e < graph.End(v); e++) {
+                uint32_t w = graph.Target(e);
+                if (v < w && cell[v] != cell[w]) level.cutEdges++;
+            }
+        }
+        if (level.cells == 0) continue;
+        level.maxCellSize = *std::max_element(sizes.begin(), sizes.end());
+        level.imbalance = level.maxCellSize / (static_cast<double>(graph.NodeCount()) / level.cells);
+    }
+    return quality;
+}
+
+#endif
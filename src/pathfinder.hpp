@@ -1,71 +1,158 @@
 #ifndef PATHFINDER_HPP
 #define PATHFINDER_HPP
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
+#include <memory>
 #include <vector>
-#include <unordered_map>
 #include "graph.hpp"
+#include "search.hpp"
+#include "spt_cache.hpp"
 
-template<typename Key, typename Value>
-using umap = std::unordered_map<Key, Value>;
-using string = std::string;
 
+// Network Voronoi partition: every node's nearest facility (NoNode if none
+// reaches it) and the distance to it, indexed by node
+struct FacilityPartition {
+    static constexpr uint32_t NoNode = std::numeric_limits<uint32_t>::max();
 
+    std::vector<uint32_t> owner;
+    std::vector<double> dist;
+};
+
+
+// Searches run on dense node indices (Graph::NearestNode / Graph::IndexOf).
 class Pathfinder {
     private:
-    string m_StartNode, m_EndNode;
-    umap<string, double> m_Dist;
-    umap<string, string> m_Prev;
-    umap<string, Node> m_Graph;
+    uint32_t m_StartNode = ShortestPathTree::NoNode, m_EndNode = ShortestPathTree::NoNode;
+    std::shared_ptr<const ShortestPathTree> m_Tree;
+    const Graph& m_Graph;
+    SptCache* m_Cache = nullptr;
+    ::Search<Graph, double> m_Search; // Qualified: Search() below is the query method
+    std::unique_ptr<::Search<Graph, double, BinaryHeap, NoHeuristic, RangeVisitor>> m_Range; // On first use
 
     public:
-    Pathfinder(const umap<string, Node>& graph, const string& startNode, const string& endNode)
-        : m_StartNode(startNode), m_EndNode(endNode), m_Graph(graph) 
+    Pathfinder(const Graph& graph, uint32_t startNode, uint32_t endNode)
+        : m_Graph(graph), m_Search(graph)
     {
-        if (m_Graph.find(m_StartNode) == m_Graph.end()){
-            throw std::runtime_error("Start node not found in graph\n");
+        Search(startNode, endNode);
+    }
+
+    // Workspace mode: bind to a shared graph once and call Search() per query.
+    // The shortest path tree of the last source is kept, so a query that only
+    // changes the destination is answered straight from it. With a cache, trees
+    // of recently used sources are kept (and shared between workspaces) too.
+    explicit Pathfinder(const Graph& graph, SptCache* cache = nullptr)
+        : m_Graph(graph), m_Cache(cache), m_Search(graph) {}
+
+    void Search(uint32_t startNode, uint32_t endNode) {
+        if (startNode >= m_Graph.NodeCount() || endNode >= m_Graph.NodeCount()){
+            throw std::runtime_error("Start or end node not found in graph\n");
         }
-        // Can switch to other algorithms later
-        dijkstra();
+        m_EndNode = endNode;
+        if (m_Tree && startNode == m_StartNode) return;
+
+        m_StartNode = startNode;
+        if (m_Cache && (m_Tree = m_Cache->Get(startNode))) return;
+
+        auto tree = std::make_shared<ShortestPathTree>();
+        tree->source = startNode;
+        dijkstra(*tree);
+
+        m_Tree = std::move(tree);
+        if (m_Cache) m_Cache->Put(m_Tree);
+    }
+
+    inline bool Reachable() const {
+        return m_Tree->dist[m_EndNode] != std::numeric_limits<double>::infinity();
+    }
+
+    inline const std::vector<double>& GetDistances() const { return m_Tree->dist; }
+    // Sized by a first walk up the tree, so it allocates exactly once
+    inline std::vector<uint32_t> GetPath() const {
+        std::vector<uint32_t> path;
+        if (!Reachable()) return path;
+
+        size_t length = 0;
+        for (uint32_t at = m_EndNode; at != ShortestPathTree::NoNode; at = m_Tree->prev[at]) length++;
+        path.resize(length);
+        for (uint32_t at = m_EndNode; at != ShortestPathTree::NoNode; at = m_Tree->prev[at]) path[--length] = at;
+        return path;
     }
 
-    inline const umap<string, double> GetDistances() const { return m_Dist; }
-    inline std::vector<string> GetPath() const {
-        std::vector<string> path;
-        for (string at = m_EndNode; !at.empty(); at = m_Prev.at(at)) {
-            path.push_back(at);
-            if (at == m_StartNode) break;
+    // Range query: every node within `limit` of startNode (edge-weight units,
+    // metres for the bundled export; divide by speed for a time budget), in
+    // settle order. The search stops at the bound instead of settling the
+    // whole graph, on a dense workspace kept for the next query.
+    std::vector<std::pair<uint32_t, double>> SearchWithin(uint32_t startNode, double limit) {
+        if (startNode >= m_Graph.NodeCount()){
+            throw std::runtime_error("Start node not found in graph\n");
         }
-        std::reverse(path.begin(), path.end());
-        return path; 
+        auto& search = rangeSearch();
+        search.GetVisitor().limit = limit;
+        search.Run(startNode);
+        return std::move(search.GetVisitor().settled);
     }
 
-    private:
-    void dijkstra() {
-        for (const auto& [id, _]: m_Graph)
-            m_Dist[id] = std::numeric_limits<double>::infinity();
-        
-
-        using Pair = std::pair<double, string>;
-        std::priority_queue<Pair, std::vector<Pair>, std::greater<>> pq;
-
-        m_Dist[m_StartNode] = 0;
-        pq.emplace(0, m_StartNode);
-
-        while (!pq.empty()){
-            auto [cost, u] = pq.top(); pq.pop();
-            
-            const auto& neighbours = m_Graph[u].neighbours;
-            for (auto& [v, weight]: neighbours) {
-                double alt = m_Dist[u] + weight;
-                if (alt < m_Dist[v]){
-                    m_Dist[v] = alt;
-                    m_Prev[v] = u;
-                    pq.emplace(alt, v);
+    // Multi-source search: all facilities start at distance 0 and each node
+    // inherits the owner of the node it was reached from, so one search
+    // assigns every reachable node to its nearest facility. Distances run
+    // from the facility along edge direction. Nodes folded by
+    // Graph::ContractChains() take the owner of the chain end they are
+    // nearest to, at their distance along the chain.
+    FacilityPartition NearestFacilities(const std::vector<uint32_t>& facilities) {
+        const auto& G = m_Graph.getGraph();
+        for (uint32_t facility: facilities) {
+            if (facility >= G.size()){
+                throw std::runtime_error("Facility node not found in graph\n");
+            }
+        }
+
+        auto& search = rangeSearch();
+        search.GetVisitor().limit = std::numeric_limits<double>::infinity();
+        search.RunFrom(facilities);
+
+        FacilityPartition partition;
+        auto& dist = partition.dist;
+        auto& owner = partition.owner;
+        dist.assign(G.size(), std::numeric_limits<double>::infinity());
+        owner.assign(G.size(), FacilityPartition::NoNode);
+
+        // Settle order: a node's predecessor already has its owner
+        const auto& prev = search.Predecessors();
+        for (const auto& [v, d]: search.GetVisitor().settled) {
+            dist[v] = d;
+            owner[v] = prev[v] == ShortestPathTree::NoNode ? v : owner[prev[v]];
+        }
+
+        for (uint32_t u = 0; u < G.size(); u++) {
+            if (owner[u] == FacilityPartition::NoNode) continue;
+            for (const auto& [v, _]: G[u].neighbours) {
+                const auto* via = m_Graph.Via(u, v);
+                if (!via) continue;
+                for (const auto& [w, offset]: *via) {
+                    if (dist[u] + offset < dist[w]) {
+                        dist[w] = dist[u] + offset;
+                        owner[w] = owner[u];
+                    }
                 }
             }
         }
+        return partition;
+    }
+
+    private:
+    ::Search<Graph, double, BinaryHeap, NoHeuristic, RangeVisitor>& rangeSearch() {
+        if (!m_Range) m_Range = std::make_unique<::Search<Graph, double, BinaryHeap, NoHeuristic, RangeVisitor>>(m_Graph);
+        m_Range->GetVisitor().settled.clear();
+        return *m_Range;
+    }
+
+    void dijkstra(ShortestPathTree& tree) {
+        m_Search.Run(m_StartNode);
+        tree.dist = m_Search.Distances();
+        tree.prev = m_Search.Predecessors();
     }
 };
 
-#endif
\ No newline at end of file
+#endif
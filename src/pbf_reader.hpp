@@ -0,0 +1,375 @@
+#ifndef PBF_READER_HPP
+#define PBF_READER_HPP
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <zlib.h>
+
+// Reader for OpenStreetMap .osm.pbf extracts. The file is a sequence of
+// (BlobHeader, Blob) pairs; each OSMData blob inflates to a self-contained
+// PrimitiveBlock, so blobs can be located with one cheap scan and then
+// decoded on any number of threads. Only the fields routing needs are
+// decoded (node coordinates, way tags and node references); the protobuf
+// wire format is parsed directly rather than through generated code.
+
+inline int64_t ZigZag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+// Cursor over one protobuf message
+class ProtoReader {
+    private:
+    const uint8_t* m_Pos;
+    const uint8_t* m_End;
+    uint32_t m_Field = 0, m_Wire = 0;
+
+    public:
+    ProtoReader(const uint8_t* data, size_t size)
+        : m_Pos(data), m_End(data + size) {}
+
+    // Advances to the next field; false at the end of the message
+    bool Next() {
+        if (m_Pos >= m_End) return false;
+        uint64_t tag = Varint();
+        m_Field = static_cast<uint32_t>(tag >> 3);
+        m_Wire = static_cast<uint32_t>(tag & 7);
+        return true;
+    }
+
+    inline uint32_t Field() const { return m_Field; }
+    inline uint32_t Wire() const { return m_Wire; }
+
+    uint64_t Varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (m_Pos >= m_End) break;
+            uint8_t byte = *m_Pos++;
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return value;
+        }
+        throw std::runtime_error("Malformed varint in PBF block\n");
+    }
+
+    inline int64_t Sint() { return ZigZag(Varint()); }
+
+    std::string_view Bytes() {
+        uint64_t size = Varint();
+        if (size > static_cast<uint64_t>(m_End - m_Pos)) {
+            throw std::runtime_error("Truncated field in PBF block\n");
+        }
+        std::string_view bytes(reinterpret_cast<const char*>(m_Pos), size);
+        m_Pos += size;
+        return bytes;
+    }
+
+    inline ProtoReader Message() {
+        std::string_view bytes = Bytes();
+        return ProtoReader(reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size());
+    }
+
+    // Repeated integer field, packed or not; fn receives each raw varint
+    template<typename Fn>
+    void Varints(Fn&& fn) {
+        if (m_Wire != 2) {
+            fn(Varint());
+            return;
+        }
+        ProtoReader packed = Message();
+        while (packed.m_Pos < packed.m_End) fn(packed.Varint());
+    }
+
+    void Skip() {
+        switch (m_Wire) {
+            case 0: Varint(); break;
+            case 1: m_Pos += 8; break;
+            case 2: Bytes(); break;
+            case 5: m_Pos += 4; break;
+            default: throw std::runtime_error("Unsupported wire type in PBF block\n");
+        }
+        if (m_Pos > m_End) {
+            throw std::runtime_error("Truncated field in PBF block\n");
+        }
+    }
+};
+
+struct OsmTag {
+    std::string_view key, value;
+};
+
+// Decoded view of one PrimitiveBlock. Views point into the inflated buffer,
+// which must outlive the block.
+class PrimitiveBlock {
+    private:
+    std::vector<std::string_view> m_Strings;
+    std::vector<std::string_view> m_Groups;
+    int64_t m_Granularity = 100, m_LatOffset = 0, m_LonOffset = 0;
+
+    public:
+    explicit PrimitiveBlock(std::string_view data) {
+        ProtoReader block(reinterpret_cast<const uint8_t*>(data.data()), data.size());
+        while (block.Next()) {
+            switch (block.Field()) {
+                case 1: {
+                    ProtoReader table = block.Message();
+                    while (table.Next()) {
+                        if (table.Field() == 1) m_Strings.push_back(table.Bytes());
+                        else table.Skip();
+                    }
+                    break;
+                }
+                case 2: m_Groups.push_back(block.Bytes()); break;
+                case 17: m_Granularity = static_cast<int64_t>(block.Varint()); break;
+                case 19: m_LatOffset = static_cast<int64_t>(block.Varint()); break;
+                case 20: m_LonOffset = static_cast<int64_t>(block.Varint()); break;
+                default: block.Skip();
+            }
+        }
+    }
+
+    // Groups hold a single primitive type, so peeking at each group's first
+    // field tells what the block contains without decoding it
+    bool Has(uint32_t groupField) const {
+        for (std::string_view group: m_Groups) {
+            ProtoReader reader(reinterpret_cast<const uint8_t*>(group.data()), group.size());
+            if (reader.Next() && reader.Field() == groupField) return true;
+        }
+        return false;
+    }
+    inline bool HasNodes() const { return Has(1) || Has(2); }
+    inline bool HasWays() const { return Has(3); }
+
+    // fn(id, lat, lon) for every node, plain or dense
+    template<typename Fn>
+    void ForEachNode(Fn&& fn) const {
+        for (std::string_view group: m_Groups) {
+            ProtoReader reader(reinterpret_cast<const uint8_t*>(group.data()), group.size());
+            while (reader.Next()) {
+                if (reader.Field() == 1) plainNode(reader.Message(), fn);
+                else if (reader.Field() == 2) denseNodes(reader.Message(), fn);
+                else reader.Skip();
+            }
+        }
+    }
+
+    // fn(id, tags, refs) for every way; the vectors are reused between calls
+    template<typename Fn>
+    void ForEachWay(Fn&& fn) const {
+        std::vector<OsmTag> tags;
+        std::vector<int64_t> refs;
+        std::vector<uint32_t> keys, values;
+        for (std::string_view group: m_Groups) {
+            ProtoReader reader(reinterpret_cast<const uint8_t*>(group.data()), group.size());
+            while (reader.Next()) {
+                if (reader.Field() != 3) {
+                    reader.Skip();
+                    continue;
+                }
+
+                ProtoReader way = reader.Message();
+                int64_t id = 0, ref = 0;
+                tags.clear(); refs.clear(); keys.clear(); values.clear();
+                while (way.Next()) {
+                    switch (way.Field()) {
+                        case 1: id = static_cast<int64_t>(way.Varint()); break;
+                        case 2: way.Varints([&](uint64_t k){ keys.push_back(static_cast<uint32_t>(k)); }); break;
+                        case 3: way.Varints([&](uint64_t v){ values.push_back(static_cast<uint32_t>(v)); }); break;
+                        case 8: way.Varints([&](uint64_t delta){ refs.push_back(ref += ZigZag(delta)); }); break;
+                        default: way.Skip();
+                    }
+                }
+                for (size_t i = 0; i < keys.size() && i < values.size(); i++) {
+                    tags.push_back({stringAt(keys[i]), stringAt(values[i])});
+                }
+                fn(id, tags, refs);
+            }
+        }
+    }
+
+    private:
+    inline std::string_view stringAt(uint32_t index) const {
+        if (index >= m_Strings.size()) {
+            throw std::runtime_error("String index out of range in PBF block\n");
+        }
+        return m_Strings[index];
+    }
+
+    inline double toDegrees(int64_t raw, int64_t offset) const {
+        return 1e-9 * static_cast<double>(offset + m_Granularity * raw);
+    }
+
+    template<typename Fn>
+    void plainNode(ProtoReader node, Fn& fn) const {
+        int64_t id = 0, lat = 0, lon = 0;
+        while (node.Next()) {
+            switch (node.Field()) {
+                case 1: id = node.Sint(); break;
+                case 8: lat = node.Sint(); break;
+                case 9: lon = node.Sint(); break;
+                default: node.Skip();
+            }
+        }
+        fn(id, toDegrees(lat, m_LatOffset), toDegrees(lon, m_LonOffset));
+    }
+
+    // Ids and coordinates are delta-coded, each in its own packed array
+    template<typename Fn>
+    void denseNodes(ProtoReader dense, Fn& fn) const {
+        std::vector<int64_t> ids, lats, lons;
+        while (dense.Next()) {
+            int64_t sum = 0;
+            switch (dense.Field()) {
+                case 1: dense.Varints([&](uint64_t d){ ids.push_back(sum += ZigZag(d)); }); break;
+                case 8: dense.Varints([&](uint64_t d){ lats.push_back(sum += ZigZag(d)); }); break;
+                case 9: dense.Varints([&](uint64_t d){ lons.push_back(sum += ZigZag(d)); }); break;
+                default: dense.Skip();
+            }
+        }
+        if (lats.size() != ids.size() || lons.size() != ids.size()) {
+            throw std::runtime_error("Mismatched DenseNodes arrays in PBF block\n");
+        }
+        for (size_t i = 0; i < ids.size(); i++) {
+            fn(ids[i], toDegrees(lats[i], m_LatOffset), toDegrees(lons[i], m_LonOffset));
+        }
+    }
+};
+
+
+// File-level access: Scan() lists the data blobs, Read() fetches and inflates
+// one of them. Read() uses pread and no shared state, so several threads may
+// call it at once.
+class PbfFile {
+    public:
+    struct BlobRef {
+        uint64_t offset;
+        uint32_t size;
+    };
+
+    private:
+    int m_Fd = -1;
+    std::vector<BlobRef> m_Blobs;
+
+    public:
+    explicit PbfFile(const std::string& path) {
+        m_Fd = open(path.c_str(), O_RDONLY);
+        if (m_Fd < 0) {
+            throw std::runtime_error("Failed to open " + path + "\n");
+        }
+        try {
+            scan();
+        } catch (...) {
+            close(m_Fd);
+            throw;
+        }
+    }
+
+    ~PbfFile() { close(m_Fd); }
+
+    PbfFile(const PbfFile&) = delete;
+    PbfFile& operator=(const PbfFile&) = delete;
+
+    inline const std::vector<BlobRef>& Blobs() const { return m_Blobs; }
+
+    // Inflated PrimitiveBlock bytes of blob i; `raw` and `out` are scratch buffers
+    void Read(size_t i, std::vector<uint8_t>& raw, std::vector<uint8_t>& out) const {
+        const BlobRef& ref = m_Blobs[i];
+        raw.resize(ref.size);
+        readAt(ref.offset, raw.data(), ref.size);
+
+        ProtoReader blob(raw.data(), raw.size());
+        std::string_view data, zlibData;
+        uint64_t rawSize = 0;
+        while (blob.Next()) {
+            switch (blob.Field()) {
+                case 1: data = blob.Bytes(); break;
+                case 2: rawSize = blob.Varint(); break;
+                case 3: zlibData = blob.Bytes(); break;
+                case 4: case 6: case 7:
+                    throw std::runtime_error("Only raw and zlib PBF blobs are supported\n");
+                default: blob.Skip();
+            }
+        }
+
+        if (!data.empty()) {
+            out.assign(data.begin(), data.end());
+            return;
+        }
+
+        out.resize(rawSize);
+        uLongf size = static_cast<uLongf>(rawSize);
+        if (uncompress(out.data(), &size, reinterpret_cast<const Bytef*>(zlibData.data()),
+                       static_cast<uLong>(zlibData.size())) != Z_OK || size != rawSize) {
+            throw std::runtime_error("Corrupt zlib blob in PBF file\n");
+        }
+    }
+
+    private:
+    void readAt(uint64_t offset, uint8_t* buffer, size_t size) const {
+        while (size > 0) {
+            ssize_t n = pread(m_Fd, buffer, size, static_cast<off_t>(offset));
+            if (n <= 0) {
+                throw std::runtime_error("Truncated PBF file\n");
+            }
+            buffer += n; offset += n; size -= n;
+        }
+    }
+
+    // Walks the headers only, remembering where each OSMData blob lives
+    void scan() {
+        off_t fileSize = lseek(m_Fd, 0, SEEK_END);
+        uint64_t offset = 0;
+        std::vector<uint8_t> header;
+        while (offset < static_cast<uint64_t>(fileSize)) {
+            uint8_t lengthBytes[4];
+            readAt(offset, lengthBytes, 4);
+            uint32_t length = (uint32_t(lengthBytes[0]) << 24) | (uint32_t(lengthBytes[1]) << 16)
+                            | (uint32_t(lengthBytes[2]) << 8) | lengthBytes[3];
+            if (length > 64 * 1024) {
+                throw std::runtime_error("Oversized BlobHeader in PBF file\n");
+            }
+            header.resize(length);
+            readAt(offset + 4, header.data(), length);
+
+            std::string_view type;
+            uint32_t dataSize = 0;
+            ProtoReader reader(header.data(), header.size());
+            while (reader.Next()) {
+                if (reader.Field() == 1) type = reader.Bytes();
+                else if (reader.Field() == 3) dataSize = static_cast<uint32_t>(reader.Varint());
+                else reader.Skip();
+            }
+
+            uint64_t blobOffset = offset + 4 + length;
+            if (type == "OSMHeader") checkHeader(blobOffset, dataSize);
+            else if (type == "OSMData") m_Blobs.push_back({blobOffset, dataSize});
+            offset = blobOffset + dataSize;
+        }
+    }
+
+    // Refuse files that need features this reader does not understand
+    void checkHeader(uint64_t offset, uint32_t size) {
+        m_Blobs.push_back({offset, size});
+        std::vector<uint8_t> raw, data;
+        Read(m_Blobs.size() - 1, raw, data);
+        m_Blobs.pop_back();
+
+        ProtoReader header(data.data(), data.size());
+        while (header.Next()) {
+            if (header.Field() != 4) {
+                header.Skip();
+                continue;
+            }
+            std::string_view feature = header.Bytes();
+            if (feature != "OsmSchema-V0.6" && feature != "DenseNodes") {
+                throw std::runtime_error("Unsupported PBF feature " + std::string(feature) + "\n");
+            }
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef PHAST_HPP
+#define PHAST_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "contraction_hierarchy.hpp"
+#include "query_arena.hpp"
+
+// One-to-all distances on a contraction hierarchy (Delling et al., PHAST).
+// An upward Dijkstra from the source is followed by one linear sweep over
+// nodes from highest to lowest rank that pulls distances down the
+// hierarchy. RunMany() handles several sources per sweep: distances are
+// interleaved per node, so the inner min/add loop is contiguous and the
+// compiler can vectorise it. One Phast per thread; the hierarchy is shared.
+class Phast {
+    public:
+    static constexpr size_t Lanes = 8;
+
+    private:
+    const ContractionHierarchy& m_Ch;
+    std::vector<double> m_Dist;   // Position-major, `lanes` values per node
+    std::vector<double> m_Result; // Original node index
+
+    public:
+    explicit Phast(const ContractionHierarchy& ch)
+        : m_Ch(ch) {}
+
+    void Run(uint32_t source) {
+        uint32_t n = m_Ch.NodeCount();
+        m_Result.resize(n);
+        runBlock(&source, 1, m_Result.data());
+    }
+
+    inline const std::vector<double>& Distances() const { return m_Result; }
+
+    // Same shape as Pathfinder::GetDistances(), given the graph the CH was built on
+    std::vector<double> GetDistances(const CsrGraph& graph) const { return graph.ToGraphOrder(m_Result); }
+
+    // Row s holds the distances from sources[s] to every node: result[s * n + v]
+    std::vector<double> RunMany(const std::vector<uint32_t>& sources) {
+        uint32_t n = m_Ch.NodeCount();
+        std::vector<double> result(sources.size() * n);
+        for (size_t first = 0; first < sources.size(); first += Lanes) {
+            size_t lanes = std::min(Lanes, sources.size() - first);
+            runBlock(sources.data() + first, lanes, result.data() + first * n);
+        }
+        return result;
+    }
+
+    private:
+    void runBlock(const uint32_t* sources, size_t lanes, double* out) {
+        uint32_t n = m_Ch.NodeCount();
+        m_Dist.assign(static_cast<size_t>(n) * lanes, std::numeric_limits<double>::infinity());
+
+        for (size_t s = 0; s < lanes; s++) upwardSearch(m_Ch.PositionOf(sources[s]), s, lanes);
+
+        for (uint32_t p = 0; p < n; p++) {
+            double* dv = &m_Dist[static_cast<size_t>(p) * lanes];
+            for (uint32_t a = m_Ch.DownBegin(p); a < m_Ch.DownEnd(p); a++) {
+                const double* du = &m_Dist[static_cast<size_t>(m_Ch.DownTail(a)) * lanes];
+                double w = m_Ch.DownWeight(a);
+                for (size_t s = 0; s < lanes; s++) dv[s] = std::min(dv[s], du[s] + w);
+            }
+        }
+
+        for (uint32_t p = 0; p < n; p++) {
+            uint32_t v = m_Ch.NodeAt(p);
+            for (size_t s = 0; s < lanes; s++) out[s * n + v] = m_Dist[static_cast<size_t>(p) * lanes + s];
+        }
+    }
+
+    void upwardSearch(uint32_t source, size_t lane, size_t lanes) {
+        QueryArena::Scope scratch;
+        auto pq = scratch.Heap<double>();
+
+        m_Dist[source * lanes + lane] = 0;
+        pq.emplace(0, source);
+
+        while (!pq.empty()){
+            auto [cost, p] = pq.top(); pq.pop();
+            if (cost > m_Dist[p * lanes + lane]) continue;
+
+            for (uint32_t a = m_Ch.UpBegin(p); a < m_Ch.UpEnd(p); a++) {
+                uint32_t q = m_Ch.UpHead(a);
+                double alt = cost + m_Ch.UpWeight(a);
+                if (alt < m_Dist[q * lanes + lane]){
+                    m_Dist[q * lanes + lane] = alt;
+                    pq.emplace(alt, q);
+                }
+            }
+        }
+    }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,180 @@
+#ifndef QUERY_ARENA_HPP
+#define QUERY_ARENA_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+// Per-thread scratch memory for the temporary containers of one query (hash
+// maps, heaps, paths). Allocation is a pointer bump into a buffer the thread
+// keeps; nothing is freed piecemeal, the whole arena is released when the
+// outermost Scope on the thread closes. A query that outgrows the buffer
+// spills to the heap once and the buffer grows to fit, so steady-state
+// queries never reach malloc.
+//
+//   QueryArena::Scope scope;
+//   std::pmr::unordered_map<uint32_t, double> dist(scope.Resource());
+//
+// Nothing allocated from a scope may outlive it.
+
+// Search min-heap of {key, node} pairs with arena storage (Scope::Heap)
+template<typename Key>
+using ScratchHeap = std::priority_queue<std::pair<Key, uint32_t>, std::pmr::vector<std::pair<Key, uint32_t>>, std::greater<>>;
+
+class QueryArena {
+    public:
+    struct Stats {
+        uint64_t queries = 0;             // Outermost scopes closed
+        uint64_t allocations = 0;         // Served by the arena
+        uint64_t bytes = 0;
+        uint64_t upstreamAllocations = 0; // Blocks the arena took from the heap
+        uint64_t peakBytes = 0;           // Largest single query
+    };
+
+    // Nests: only the outermost scope on a thread releases the arena
+    class Scope {
+        private:
+        QueryArena& m_Arena;
+
+        public:
+        Scope() : m_Arena(Local()) { m_Arena.m_Depth++; }
+        ~Scope() {
+            if (--m_Arena.m_Depth == 0) m_Arena.endQuery();
+        }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        inline std::pmr::memory_resource* Resource() const { return &m_Arena.m_Front; }
+
+        template<typename Key>
+        ScratchHeap<Key> Heap() const {
+            return ScratchHeap<Key>(std::greater<>(), std::pmr::vector<std::pair<Key, uint32_t>>(Resource()));
+        }
+    };
+
+    static QueryArena& Local() {
+        thread_local QueryArena arena;
+        return arena;
+    }
+
+    // Summed over every thread's arena, including threads that have exited
+    static Stats Totals() {
+        std::lock_guard<std::mutex> lock(registryMutex());
+        Stats total = retired();
+        for (const QueryArena* arena: registry()) arena->addTo(total);
+        return total;
+    }
+
+    QueryArena(const QueryArena&) = delete;
+    QueryArena& operator=(const QueryArena&) = delete;
+
+    private:
+    // Counts what passes through to the next resource. Only the owning
+    // thread writes, so the counters are plain loads and stores; atomics
+    // only make Totals() safe to read from another thread.
+    class CountingResource : public std::pmr::memory_resource {
+        private:
+        std::pmr::memory_resource* m_Next;
+
+        public:
+        std::atomic<uint64_t> allocations{0}, bytes{0};
+
+        explicit CountingResource(std::pmr::memory_resource* next) : m_Next(next) {}
+
+        private:
+        void* do_allocate(size_t size, size_t alignment) override {
+            allocations.store(allocations.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            bytes.store(bytes.load(std::memory_order_relaxed) + size, std::memory_order_relaxed);
+            return m_Next->allocate(size, alignment);
+        }
+
+        void do_deallocate(void* p, size_t size, size_t alignment) override {
+            m_Next->deallocate(p, size, alignment);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+    };
+
+    static constexpr size_t InitialBytes = 256 << 10;
+    static constexpr size_t MaxRetainedBytes = 64 << 20; // Larger queries spill every time
+
+    std::vector<std::byte> m_Buffer;
+    CountingResource m_Upstream{std::pmr::new_delete_resource()};
+    std::optional<std::pmr::monotonic_buffer_resource> m_Arena;
+    CountingResource m_Front;
+    std::atomic<uint64_t> m_Queries{0}, m_Peak{0};
+    uint64_t m_QueryStart = 0, m_SpillStart = 0;
+    int m_Depth = 0;
+
+    QueryArena()
+        : m_Buffer(InitialBytes),
+          m_Arena(std::in_place, m_Buffer.data(), m_Buffer.size(), &m_Upstream),
+          m_Front(&*m_Arena)
+    {
+        std::lock_guard<std::mutex> lock(registryMutex());
+        registry().push_back(this);
+    }
+
+    ~QueryArena() {
+        std::lock_guard<std::mutex> lock(registryMutex());
+        auto& arenas = registry();
+        arenas.erase(std::find(arenas.begin(), arenas.end(), this));
+        addTo(retired());
+    }
+
+    void endQuery() {
+        uint64_t used = m_Front.bytes.load(std::memory_order_relaxed) - m_QueryStart;
+        m_Queries.store(m_Queries.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        m_Peak.store(std::max(m_Peak.load(std::memory_order_relaxed), used), std::memory_order_relaxed);
+
+        bool spilled = m_Upstream.allocations.load(std::memory_order_relaxed) != m_SpillStart;
+        if (spilled && m_Buffer.size() < MaxRetainedBytes) {
+            // Grow so a query of this size fits next time (replacing the
+            // resource releases its blocks; m_Front keeps the same address)
+            size_t size = m_Buffer.size();
+            while (size < used + used / 8 && size < MaxRetainedBytes) size *= 2;
+            m_Arena.reset();
+            m_Buffer = std::vector<std::byte>(size);
+            m_Arena.emplace(m_Buffer.data(), m_Buffer.size(), &m_Upstream);
+        } else {
+            m_Arena->release();
+        }
+        m_QueryStart = m_Front.bytes.load(std::memory_order_relaxed);
+        m_SpillStart = m_Upstream.allocations.load(std::memory_order_relaxed);
+    }
+
+    void addTo(Stats& total) const {
+        total.queries += m_Queries.load(std::memory_order_relaxed);
+        total.allocations += m_Front.allocations.load(std::memory_order_relaxed);
+        total.bytes += m_Front.bytes.load(std::memory_order_relaxed);
+        total.upstreamAllocations += m_Upstream.allocations.load(std::memory_order_relaxed);
+        total.peakBytes = std::max(total.peakBytes, m_Peak.load(std::memory_order_relaxed));
+    }
+
+    static std::mutex& registryMutex() {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    static std::vector<const QueryArena*>& registry() {
+        static std::vector<const QueryArena*> arenas;
+        return arenas;
+    }
+
+    static Stats& retired() {
+        static Stats stats;
+        return stats;
+    }
+};
+
+#endif
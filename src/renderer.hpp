@@ -1,16 +1,24 @@
 #ifndef RENDERER_HPP
 #define RENDERER_HPP
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <string>
+#include <vector>
 #include <raylib/raylib.h>
 #include <raylib/raymath.h>
+#include <raylib/rlgl.h>
+#include "isochrone.hpp"
 
 class Renderer {
 private:
     int m_Width, m_Height;
     Camera2D m_Camera;
-    Image m_MapImage;
-    Texture2D m_MapTexture;
+    Texture2D m_MapTexture = {};
+    Image m_Staging = {};     // Decoded map still being uploaded
+    int m_UploadedRows = 0;
+    int m_BandRows = 64;
 
 public:
     Renderer(int width, int height, const std::string& name)
@@ -27,17 +35,44 @@ public:
     }
 
     ~Renderer() {
-        UnloadTexture(m_MapTexture);
+        if (m_Staging.data) UnloadImage(m_Staging);
+        if (MapLoaded()) UnloadTexture(m_MapTexture);
         CloseWindow();
     }
 
     inline float MapWidth() const { return m_MapTexture.width; }
     inline float MapHeight() const { return m_MapTexture.height; }
+    inline bool MapLoaded() const { return m_MapTexture.id != 0; }
+    inline float MapUploadProgress() const {
+        return MapLoaded() ? static_cast<float>(m_UploadedRows) / m_MapTexture.height : 0.0f;
+    }
 
     void LoadMap(const std::string& path) {
-        m_MapImage = LoadImage(path.c_str());
-        m_MapTexture = LoadTextureFromImage(m_MapImage);
-        UnloadImage(m_MapImage);
+        BeginMapUpload(DecodeMap(path));
+        ContinueMapUpload(INFINITY);
+    }
+
+    // CPU half of LoadMap(): file read, PNG decode and conversion to the
+    // texture's pixel format, safe on any thread
+    static Image DecodeMap(const std::string& path) {
+        Image image = LoadImage(path.c_str());
+        if (image.data) ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+        return image;
+    }
+
+    // GPU half: must run on the thread that owns the window. Allocates the
+    // texture without data and keeps the image as the staging buffer that
+    // ContinueMapUpload() copies from. Takes ownership of the image.
+    void BeginMapUpload(Image image) {
+        if (!image.data) return;
+
+        m_MapTexture.id = rlLoadTexture(nullptr, image.width, image.height, image.format, 1);
+        m_MapTexture.width = image.width;
+        m_MapTexture.height = image.height;
+        m_MapTexture.mipmaps = 1;
+        m_MapTexture.format = image.format;
+        m_Staging = image;
+        m_UploadedRows = 0;
 
         // Center camera on map
         m_Camera.target = {
@@ -46,6 +81,29 @@ public:
         };
     }
 
+    // Uploads row bands until `budget` seconds are spent (at least one band
+    // per call), so a large map fills in over several frames without a
+    // frame stalling on it. Returns true once the whole map is on the GPU.
+    bool ContinueMapUpload(double budget = 0.004) {
+        if (!m_Staging.data) return MapLoaded();
+
+        const auto* pixels = static_cast<const unsigned char*>(m_Staging.data);
+        size_t stride = GetPixelDataSize(m_Staging.width, 1, m_Staging.format);
+        double start = GetTime();
+        while (m_UploadedRows < m_Staging.height) {
+            int rows = std::min(m_BandRows, m_Staging.height - m_UploadedRows);
+            Rectangle band = {0, static_cast<float>(m_UploadedRows), static_cast<float>(m_Staging.width), static_cast<float>(rows)};
+            UpdateTextureRec(m_MapTexture, band, pixels + stride * m_UploadedRows);
+            m_UploadedRows += rows;
+            if (GetTime() - start >= budget) break;
+        }
+
+        if (m_UploadedRows < m_Staging.height) return false;
+        UnloadImage(m_Staging);
+        m_Staging = {};
+        return true;
+    }
+
     void HandleInput() {
         float wheel = GetMouseWheelMove();
         if (wheel != 0.0f) {
@@ -71,7 +129,47 @@ public:
     }
 
     void DrawMap() {
-        DrawTexture(m_MapTexture, 0, 0, WHITE);
+        // Only the rows uploaded so far hold map data
+        if (MapLoaded()) {
+            DrawTextureRec(m_MapTexture, {0, 0, MapWidth(), static_cast<float>(m_UploadedRows)}, {0, 0}, WHITE);
+        }
+    }
+
+    // Screen-space status lines with a spinner, drawn outside BeginMode2D()
+    void DrawStatus(const std::vector<std::string>& lines) const {
+        static const char* spinner[] = {"|", "/", "-", "\\"};
+        const char* frame = spinner[static_cast<int>(GetTime() * 8) % 4];
+
+        int y = 10;
+        for (const auto& line: lines) {
+            std::string text = std::string(frame) + " " + line;
+            DrawRectangle(8, y - 2, MeasureText(text.c_str(), 20) + 8, 24, Fade(BLACK, 0.6f));
+            DrawText(text.c_str(), 12, y, 20, RAYWHITE);
+            y += 28;
+        }
+    }
+
+    void DrawIsochrone(const IsochroneGrid& grid, Color color) const {
+        // Merge horizontal runs of set cells into single rectangles
+        for (int row = 0; row < grid.rows; row++) {
+            int col = 0;
+            while (col < grid.cols) {
+                if (!grid.At(col, row)) { col++; continue; }
+
+                int start = col;
+                while (col < grid.cols && grid.At(col, row)) col++;
+                DrawRectangleV(
+                    {grid.originX + start * grid.cellSize, grid.originY + row * grid.cellSize},
+                    {(col - start) * grid.cellSize, grid.cellSize},
+                    color
+                );
+            }
+        }
+    }
+
+    // Distinct, stable colours for partitions (golden-angle hue steps)
+    static Color PaletteColor(size_t index) {
+        return ColorFromHSV(std::fmod(index * 137.508f, 360.0f), 0.65f, 0.9f);
     }
 
     inline bool Running() const { return !WindowShouldClose(); }
@@ -85,16 +183,6 @@ public:
     }
     
     const Camera2D& GetCamera() const { return m_Camera; }
-    
-    // Utility method for precise coordinate conversion
-    Vector2 LatLonToPixel(double lat, double lon, 
-                         double lat_min, double lat_max, 
-                         double lon_min, double lon_max) const {
-        double x = ((lon - lon_min) / (lon_max - lon_min)) * static_cast<double>(m_MapTexture.width);
-        double y = ((lat_max - lat) / (lat_max - lat_min)) * static_cast<double>(m_MapTexture.height);
-        
-        return {static_cast<float>(x), static_cast<float>(y)};
-    }
 };
 
 #endif
\ No newline at end of file
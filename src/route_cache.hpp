@@ -0,0 +1,135 @@
+#ifndef ROUTE_CACHE_HPP
+#define ROUTE_CACHE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+// Snapped endpoints (dense node indices) plus the caller's algorithm and
+// weight profile tags, so different engines never share entries.
+struct RouteKey {
+    uint32_t start, end;
+    uint16_t algorithm = 0, profile = 0;
+
+    bool operator==(const RouteKey& other) const {
+        return start == other.start && end == other.end
+            && algorithm == other.algorithm && profile == other.profile;
+    }
+};
+
+struct RouteKeyHash {
+    size_t operator()(const RouteKey& key) const {
+        uint64_t h = (static_cast<uint64_t>(key.start) << 32) | key.end;
+        h ^= (static_cast<uint64_t>(key.algorithm) << 16 | key.profile) * 0x9E3779B97F4A7C15ull;
+        h ^= h >> 29; h *= 0xBF58476D1CE4E5B9ull; h ^= h >> 32;
+        return static_cast<size_t>(h);
+    }
+};
+
+// Distance plus the path as dense node indices; infinity and an empty path
+// record a known-unreachable pair.
+struct CachedRoute {
+    double distance;
+    std::vector<uint32_t> path;
+};
+
+// CLOCK-replacement cache for finished routes under a byte budget. Lookups
+// take a shared lock and only flip the entry's reference bit, so any number
+// of query threads can read concurrently; inserts take the exclusive lock.
+class RouteCache {
+    private:
+    struct Slot {
+        RouteKey key{};
+        std::shared_ptr<const CachedRoute> route;
+        std::atomic<bool> referenced{false};
+    };
+
+    std::deque<Slot> m_Slots;
+    std::vector<size_t> m_Free;
+    std::unordered_map<RouteKey, size_t, RouteKeyHash> m_Index;
+    size_t m_Hand = 0;
+    size_t m_Capacity, m_Bytes = 0;
+    std::atomic<uint64_t> m_Hits{0}, m_Misses{0};
+    mutable std::shared_mutex m_Mutex;
+
+    public:
+    explicit RouteCache(size_t capacityBytes)
+        : m_Capacity(capacityBytes) {}
+
+    std::shared_ptr<const CachedRoute> Get(const RouteKey& key) {
+        std::shared_lock<std::shared_mutex> lock(m_Mutex);
+        auto it = m_Index.find(key);
+        if (it == m_Index.end()) {
+            m_Misses.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        m_Hits.fetch_add(1, std::memory_order_relaxed);
+
+        Slot& slot = m_Slots[it->second];
+        slot.referenced.store(true, std::memory_order_relaxed);
+        return slot.route;
+    }
+
+    void Put(const RouteKey& key, CachedRoute route) {
+        auto entry = std::make_shared<const CachedRoute>(std::move(route));
+        size_t bytes = entryBytes(*entry);
+        if (bytes > m_Capacity) return;
+
+        std::unique_lock<std::shared_mutex> lock(m_Mutex);
+        if (m_Index.count(key)) return;
+
+        while (m_Bytes + bytes > m_Capacity) evictOne();
+
+        size_t index;
+        if (!m_Free.empty()) {
+            index = m_Free.back();
+            m_Free.pop_back();
+        } else {
+            index = m_Slots.size();
+            m_Slots.emplace_back();
+        }
+
+        Slot& slot = m_Slots[index];
+        slot.key = key;
+        slot.route = std::move(entry);
+        slot.referenced.store(false, std::memory_order_relaxed);
+        m_Index[key] = index;
+        m_Bytes += bytes;
+    }
+
+    inline uint64_t Hits() const { return m_Hits.load(std::memory_order_relaxed); }
+    inline uint64_t Misses() const { return m_Misses.load(std::memory_order_relaxed); }
+    inline size_t Bytes() const { std::shared_lock<std::shared_mutex> lock(m_Mutex); return m_Bytes; }
+    inline size_t Size() const { std::shared_lock<std::shared_mutex> lock(m_Mutex); return m_Index.size(); }
+
+    private:
+    static size_t entryBytes(const CachedRoute& route) {
+        // Slot, route header, path payload and the index's hash node
+        return sizeof(Slot) + sizeof(CachedRoute) + route.path.capacity() * sizeof(uint32_t)
+            + sizeof(RouteKey) + sizeof(size_t) + 2 * sizeof(void*);
+    }
+
+    // Sweep the clock hand, giving referenced entries a second chance
+    void evictOne() {
+        while (true) {
+            if (m_Hand >= m_Slots.size()) m_Hand = 0;
+            Slot& slot = m_Slots[m_Hand++];
+            if (!slot.route) continue;
+
+            if (slot.referenced.exchange(false, std::memory_order_relaxed)) continue;
+
+            m_Bytes -= entryBytes(*slot.route);
+            m_Index.erase(slot.key);
+            slot.route.reset();
+            m_Free.push_back(m_Hand - 1);
+            return;
+        }
+    }
+};
+
+#endif
\ No newline at end of file
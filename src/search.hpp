@@ -0,0 +1,457 @@
+#ifndef SEARCH_HPP
+#define SEARCH_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "csr_graph.hpp"
+#include "graph.hpp"
+#include "graph_traits.hpp"
+#include "simd_kernels.hpp"
+
+// Policy-based point-to-point / one-to-all search. Every piece the inner loop
+// touches is a template parameter, so each combination is compiled into its
+// own loop with the edge walk, queue, heuristic and visitor inlined:
+//
+//   Search<Graph, double>                                      plain Dijkstra
+//   Search<Graph, double, BinaryHeap, PlanarHeuristic>         A* on projected x/y
+//   Search<CsrGraph, uint32_t, RadixHeap, HaversineHeuristic>  A* on fixed point
+//
+// RouteSearch at the bottom is the runtime switch for callers that pick the
+// combination from user input.
+
+
+// Queues: Push(key, node), Pop() -> {key, node}, Empty(), Clear()
+
+// Binary min-heap; any key type
+template<typename W>
+class BinaryHeap {
+    private:
+    using Entry = std::pair<W, uint32_t>;
+    std::vector<Entry> m_Heap;
+
+    public:
+    inline bool Empty() const { return m_Heap.empty(); }
+    inline void Clear() { m_Heap.clear(); }
+
+    inline void Push(W key, uint32_t v) {
+        m_Heap.emplace_back(key, v);
+        std::push_heap(m_Heap.begin(), m_Heap.end(), std::greater<>());
+    }
+
+    inline Entry Pop() {
+        std::pop_heap(m_Heap.begin(), m_Heap.end(), std::greater<>());
+        Entry top = m_Heap.back();
+        m_Heap.pop_back();
+        return top;
+    }
+};
+
+// Monotone radix heap for unsigned integer keys: keys pushed are never below
+// the last key popped (true for Dijkstra and for A* with a consistent
+// heuristic). Entries sit in buckets by the highest bit in which they differ
+// from the last popped key and move to a lower bucket at most once per bit.
+template<typename W>
+class RadixHeap {
+    static_assert(std::is_unsigned_v<W>, "RadixHeap needs unsigned integer keys");
+
+    private:
+    using Entry = std::pair<W, uint32_t>;
+    static constexpr int Buckets = std::numeric_limits<W>::digits + 1;
+    std::vector<Entry> m_Buckets[Buckets];
+    W m_Last = 0;
+    size_t m_Size = 0;
+
+    inline int bucketOf(W key) const {
+        return key == m_Last ? 0 : 64 - __builtin_clzll(static_cast<unsigned long long>(key ^ m_Last));
+    }
+
+    public:
+    inline bool Empty() const { return m_Size == 0; }
+
+    inline void Clear() {
+        for (auto& bucket: m_Buckets) bucket.clear();
+        m_Last = 0;
+        m_Size = 0;
+    }
+
+    inline void Push(W key, uint32_t v) {
+        if (key < m_Last) throw std::runtime_error("RadixHeap key below the last popped key\n");
+        m_Buckets[bucketOf(key)].emplace_back(key, v);
+        m_Size++;
+    }
+
+    inline Entry Pop() {
+        if (m_Buckets[0].empty()) {
+            int i = 1;
+            while (m_Buckets[i].empty()) i++;
+            auto& bucket = m_Buckets[i];
+            m_Last = std::min_element(bucket.begin(), bucket.end())->first;
+            for (const Entry& entry: bucket) m_Buckets[bucketOf(entry.first)].push_back(entry);
+            bucket.clear();
+        }
+        Entry top = m_Buckets[0].back();
+        m_Buckets[0].pop_back();
+        m_Size--;
+        return top;
+    }
+};
+
+
+// Heuristics: Enabled, Batched, SetTarget(graph, target), Estimate<W>(graph,
+// v), and with Batched, EstimateBatch<W>(graph, nodes, count, out) which the
+// search calls with the unestimated neighbours of each settled node
+
+// Dijkstra: compiled out entirely
+struct NoHeuristic {
+    static constexpr bool Enabled = false;
+    static constexpr bool Batched = false;
+
+    template<typename GraphT>
+    void SetTarget(const GraphT&, uint32_t) {}
+
+    template<typename W, typename GraphT>
+    W Estimate(const GraphT&, uint32_t) const { return 0; }
+};
+
+// Great-circle distance to the target on the same sphere the edge lengths
+// were measured on, so it never overestimates and is consistent
+struct HaversineHeuristic {
+    static constexpr bool Enabled = true;
+    static constexpr bool Batched = false;
+    static constexpr double EarthRadius = 6371009.0, Rad = M_PI / 180.0;
+
+    double targetLat = 0, targetLon = 0, targetCos = 1;
+
+    template<typename GraphT>
+    void SetTarget(const GraphT& graph, uint32_t target) {
+        targetLat = GraphTraits<GraphT>::Lat(graph, target) * Rad;
+        targetLon = GraphTraits<GraphT>::Lon(graph, target) * Rad;
+        targetCos = std::cos(targetLat);
+    }
+
+    template<typename W, typename GraphT>
+    W Estimate(const GraphT& graph, uint32_t v) const {
+        double lat = GraphTraits<GraphT>::Lat(graph, v) * Rad, lon = GraphTraits<GraphT>::Lon(graph, v) * Rad;
+        double sinLat = std::sin((lat - targetLat) / 2), sinLon = std::sin((lon - targetLon) / 2);
+        double a = sinLat * sinLat + std::cos(lat) * targetCos * sinLon * sinLon;
+        double metres = 2 * EarthRadius * std::asin(std::min(1.0, std::sqrt(a)));
+        return WeightTraits<W>::LowerBoundFromMetres(metres * (1 - 1e-9)); // Rounding slack
+    }
+};
+
+// Straight-line distance on the Graph's planar projection (X()/Y(), which
+// CsrGraph copies), scaled by HeuristicScale() so it stays below the
+// great-circle distance. Neighbours are estimated in batches with the SIMD
+// kernel; no trig per node.
+struct PlanarHeuristic {
+    static constexpr bool Enabled = true;
+    static constexpr bool Batched = true;
+    static constexpr float Slack = 0.5f; // Metres, for float coordinates far from the centre
+
+    float targetX = 0, targetY = 0, scale = 1;
+    std::vector<float> batch;
+
+    template<typename GraphT>
+    void SetTarget(const GraphT& graph, uint32_t target) {
+        targetX = graph.X()[target];
+        targetY = graph.Y()[target];
+        scale = static_cast<float>(graph.HeuristicScale());
+    }
+
+    template<typename W, typename GraphT>
+    W Estimate(const GraphT& graph, uint32_t v) const {
+        float out;
+        simd::DistancesTo(graph.X().data(), graph.Y().data(), &v, 1, targetX, targetY, scale, &out);
+        return WeightTraits<W>::LowerBoundFromMetres(std::max(0.0f, out - Slack));
+    }
+
+    template<typename W, typename GraphT>
+    void EstimateBatch(const GraphT& graph, const uint32_t* nodes, size_t count, W* out) {
+        batch.resize(count);
+        simd::DistancesTo(graph.X().data(), graph.Y().data(), nodes, count, targetX, targetY, scale, batch.data());
+        for (size_t i = 0; i < count; i++) out[i] = WeightTraits<W>::LowerBoundFromMetres(std::max(0.0f, batch[i] - Slack));
+    }
+};
+
+
+// Visitors: OnSettle(node, distance) runs as each node is settled (again if
+// an inconsistent heuristic reopens it); returning false ends the search
+struct NullVisitor {
+    template<typename W>
+    inline bool OnSettle(uint32_t, W) { return true; }
+};
+
+struct CountingVisitor {
+    size_t settled = 0;
+
+    template<typename W>
+    inline bool OnSettle(uint32_t, W) {
+        settled++;
+        return true;
+    }
+};
+
+// Range query: records settled nodes in order and stops at the first one
+// beyond `limit` (in the search's weight units)
+struct RangeVisitor {
+    double limit = std::numeric_limits<double>::infinity();
+    std::vector<std::pair<uint32_t, double>> settled;
+
+    template<typename W>
+    inline bool OnSettle(uint32_t v, W distance) {
+        if (distance > limit) return false;
+        settled.emplace_back(v, distance);
+        return true;
+    }
+};
+
+// One-to-many: stops once every marked target is settled. Mark targets
+// with Add() before the run and Clear() them after.
+struct TargetsVisitor {
+    std::vector<uint8_t> state; // Per node: 0, 1 target, 2 target settled
+    size_t remaining = 0;
+
+    explicit TargetsVisitor(uint32_t nodeCount = 0) : state(nodeCount, 0) {}
+
+    inline void Add(uint32_t v) {
+        if (state[v] == 0) remaining++;
+        state[v] = 1;
+    }
+
+    inline void Clear(const std::vector<uint32_t>& targets) {
+        for (uint32_t v: targets) state[v] = 0;
+        remaining = 0;
+    }
+
+    template<typename W>
+    inline bool OnSettle(uint32_t v, W) {
+        if (state[v] == 1) {
+            state[v] = 2;
+            remaining--;
+        }
+        return remaining > 0;
+    }
+};
+
+
+// Distances, predecessors and the queue persist between runs and only the
+// nodes the previous run touched are reset, so a short query on a large graph
+// costs what it visits. One instance per thread; the graph can be shared.
+template<typename GraphT, typename W, template<typename> class Queue = BinaryHeap,
+         typename Heuristic = NoHeuristic, typename Visitor = NullVisitor>
+class Search {
+    public:
+    static constexpr uint32_t NoNode = std::numeric_limits<uint32_t>::max();
+    static constexpr W Unreachable = WeightTraits<W>::Infinity();
+    using Traits = GraphTraits<GraphT>;
+
+    private:
+    const GraphT& m_Graph;
+    std::vector<W> m_Dist, m_Estimate, m_BatchEstimate;
+    std::vector<uint32_t> m_Prev, m_Touched, m_Estimated, m_Batch;
+    std::vector<uint8_t> m_HasEstimate;
+    Queue<W> m_Queue;
+    Heuristic m_Heuristic;
+    Visitor m_Visitor;
+
+    public:
+    explicit Search(const GraphT& graph, Heuristic heuristic = {}, Visitor visitor = {})
+        : m_Graph(graph),
+          m_Dist(Traits::NodeCount(graph), Unreachable),
+          m_Prev(Traits::NodeCount(graph), NoNode),
+          m_Heuristic(std::move(heuristic)),
+          m_Visitor(std::move(visitor))
+    {
+        Traits::template RequireWeights<W>(graph);
+        if constexpr (Heuristic::Enabled) {
+            m_Estimate.assign(Traits::NodeCount(graph), 0);
+            m_HasEstimate.assign(Traits::NodeCount(graph), 0);
+        }
+    }
+
+    // Settles nodes from source until target is settled, or every reachable
+    // node when target is NoNode (Dijkstra only), or the visitor stops it.
+    // Returns the distance to target (Unreachable if none or not reached).
+    W Run(uint32_t source, uint32_t target = NoNode) {
+        return run(&source, &source + 1, target);
+    }
+
+    // Multi-source: every source starts at distance 0, so each node settles
+    // at its distance from the nearest one; the predecessor chain of a node
+    // ends at that source (Dijkstra only)
+    void RunFrom(const std::vector<uint32_t>& sources) {
+        static_assert(!Heuristic::Enabled, "A heuristic search needs a single target");
+        run(sources.data(), sources.data() + sources.size(), NoNode);
+    }
+
+    // Valid for nodes settled by the last run
+    inline W Distance(uint32_t v) const { return m_Dist[v]; }
+    inline const std::vector<W>& Distances() const { return m_Dist; }
+    inline const std::vector<uint32_t>& Predecessors() const { return m_Prev; }
+
+    std::vector<uint32_t> Path(uint32_t target) const {
+        std::vector<uint32_t> path;
+        if (m_Dist[target] == Unreachable) return path;
+        for (uint32_t at = target; at != NoNode; at = m_Prev[at]) path.push_back(at);
+        std::reverse(path.begin(), path.end());
+        return path;
+    }
+
+    inline Visitor& GetVisitor() { return m_Visitor; }
+
+    private:
+    W run(const uint32_t* sourcesBegin, const uint32_t* sourcesEnd, uint32_t target) {
+        uint32_t n = Traits::NodeCount(m_Graph);
+        for (const uint32_t* source = sourcesBegin; source != sourcesEnd; source++) {
+            if (*source >= n) throw std::runtime_error("Start or end node not found in graph\n");
+        }
+        if (target != NoNode && target >= n) throw std::runtime_error("Start or end node not found in graph\n");
+        if constexpr (Heuristic::Enabled) {
+            if (target == NoNode) throw std::runtime_error("A heuristic search needs a target\n");
+            m_Heuristic.SetTarget(m_Graph, target);
+        }
+        reset();
+
+        for (const uint32_t* source = sourcesBegin; source != sourcesEnd; source++) {
+            if (m_Dist[*source] == 0) continue; // Listed twice
+            touch(*source);
+            m_Dist[*source] = 0;
+            m_Queue.Push(estimate(*source), *source);
+        }
+
+        while (!m_Queue.Empty()) {
+            auto [key, u] = m_Queue.Pop();
+            W cost = m_Dist[u];
+            if (key > cost + estimate(u)) continue; // Stale queue entry
+            if (!m_Visitor.OnSettle(u, cost) || u == target) break;
+
+            if constexpr (Heuristic::Batched) estimateNeighbours(u);
+            Traits::template ForEachEdge<W>(m_Graph, u, [&](uint32_t v, W weight){
+                W alt = cost + weight;
+                if constexpr (std::is_integral_v<W>) {
+                    if (alt < cost) return; // Wrapped around
+                }
+                if (alt < m_Dist[v]) {
+                    if (m_Dist[v] == Unreachable) touch(v);
+                    m_Dist[v] = alt;
+                    m_Prev[v] = u;
+                    m_Queue.Push(alt + estimate(v), v);
+                }
+            });
+        }
+        return target == NoNode ? Unreachable : m_Dist[target];
+    }
+
+    inline void touch(uint32_t v) { m_Touched.push_back(v); }
+
+    // Heuristic value of v, computed once per run
+    inline W estimate(uint32_t v) {
+        if constexpr (!Heuristic::Enabled) {
+            return 0;
+        } else {
+            if (!m_HasEstimate[v]) {
+                m_Estimate[v] = m_Heuristic.template Estimate<W>(m_Graph, v);
+                m_HasEstimate[v] = 1;
+                m_Estimated.push_back(v);
+            }
+            return m_Estimate[v];
+        }
+    }
+
+    // Fills the estimate cache for u's neighbours in one heuristic call
+    void estimateNeighbours(uint32_t u) {
+        m_Batch.clear();
+        Traits::template ForEachEdge<W>(m_Graph, u, [&](uint32_t v, W){
+            if (m_HasEstimate[v]) return;
+            m_HasEstimate[v] = 1; // Also skips a repeated neighbour
+            m_Batch.push_back(v);
+        });
+        if (m_Batch.empty()) return;
+        m_BatchEstimate.resize(m_Batch.size());
+        m_Heuristic.template EstimateBatch<W>(m_Graph, m_Batch.data(), m_Batch.size(), m_BatchEstimate.data());
+        for (size_t i = 0; i < m_Batch.size(); i++) m_Estimate[m_Batch[i]] = m_BatchEstimate[i];
+        m_Estimated.insert(m_Estimated.end(), m_Batch.begin(), m_Batch.end());
+    }
+
+    void reset() {
+        for (uint32_t v: m_Touched) {
+            m_Dist[v] = Unreachable;
+            m_Prev[v] = NoNode;
+        }
+        m_Touched.clear();
+        for (uint32_t v: m_Estimated) m_HasEstimate[v] = 0;
+        m_Estimated.clear();
+        m_Queue.Clear();
+    }
+};
+
+
+enum class Algorithm { Dijkstra, AStar };
+
+// Runtime choice of algorithm and weight type, e.g. from the command line.
+// Each choice is its own Search specialisation, created on first use; the
+// switch happens once per query, never inside the search loop. Double
+// weights search the Graph directly; fixed point searches a
+// WeightFormat::Decimetres CsrGraph built on first use, so its edges are
+// read as stored uint32 and paths are mapped back to Graph indices.
+class RouteSearch {
+    public:
+    struct Result {
+        double distance = std::numeric_limits<double>::infinity(); // Metres
+        std::vector<uint32_t> path;
+        size_t settled = 0;
+    };
+
+    private:
+    const Graph& m_Graph;
+    std::unique_ptr<CsrGraph> m_Fixed;
+    std::unique_ptr<Search<Graph, double, BinaryHeap, NoHeuristic, CountingVisitor>> m_Dijkstra;
+    std::unique_ptr<Search<Graph, double, BinaryHeap, PlanarHeuristic, CountingVisitor>> m_AStar;
+    std::unique_ptr<Search<CsrGraph, uint32_t, RadixHeap, NoHeuristic, CountingVisitor>> m_FixedDijkstra;
+    std::unique_ptr<Search<CsrGraph, uint32_t, RadixHeap, PlanarHeuristic, CountingVisitor>> m_FixedAStar;
+
+    template<typename S, typename GraphT>
+    Result run(std::unique_ptr<S>& search, const GraphT& graph, uint32_t source, uint32_t target) {
+        if (!search) search = std::make_unique<S>(graph);
+        search->GetVisitor().settled = 0;
+
+        Result result;
+        auto distance = search->Run(source, target);
+        if (distance != S::Unreachable) {
+            result.distance = WeightTraits<decltype(distance)>::ToMetres(distance);
+            result.path = search->Path(target);
+        }
+        result.settled = search->GetVisitor().settled;
+        return result;
+    }
+
+    template<typename S>
+    Result runFixed(std::unique_ptr<S>& search, uint32_t source, uint32_t target) {
+        if (!m_Fixed) m_Fixed = std::make_unique<CsrGraph>(m_Graph, WeightFormat::Decimetres);
+        Result result = run(search, *m_Fixed, m_Fixed->FromGraph(source), m_Fixed->FromGraph(target));
+        for (uint32_t& v: result.path) v = m_Fixed->ToGraph(v);
+        return result;
+    }
+
+    public:
+    explicit RouteSearch(const Graph& graph) : m_Graph(graph) {}
+
+    Result Route(uint32_t source, uint32_t target, Algorithm algorithm, WeightFormat weights = WeightFormat::Double) {
+        if (weights == WeightFormat::Double) {
+            if (algorithm == Algorithm::AStar) return run(m_AStar, m_Graph, source, target);
+            return run(m_Dijkstra, m_Graph, source, target);
+        }
+        if (algorithm == Algorithm::AStar) return runFixed(m_FixedAStar, source, target);
+        return runFixed(m_FixedDijkstra, source, target);
+    }
+};
+
+#endif
@@ -0,0 +1,171 @@
+#include "graph.hpp"
+#include "pathfinder.hpp"
+#include "csr_graph.hpp"
+#include "distance_table.hpp"
+#include "route_cache.hpp"
+#include "http_server.hpp"
+#include "query_arena.hpp"
+#include "thread_pool.hpp"
+#include <memory>
+#include <memory_resource>
+#include <sstream>
+
+// Resident routing service: the graph is loaded once and queries are spread
+// over a fixed pool of threads, each owning its own Pathfinder and
+// DistanceTable workspace. Shortest path trees of recent sources are shared
+// through an LRU cache, so repeated origins skip the search entirely, and
+// finished routes are kept in a CLOCK cache keyed by the snapped node pair.
+// Points snap to the largest strongly connected component, so every query
+// has an answer and no search ever exhausts a disconnected island.
+//
+//   ./route_server [port] [threads] [graph.json] [spt_cache_mb] [route_cache_mb]
+//   GET /route?from=lat,lon&to=lat,lon
+//   GET /table?sources=lat,lon;lat,lon&destinations=lat,lon;lat,lon
+//   GET /stats
+
+static std::pair<double, double> parseLatLon(const std::string& text) {
+    double lat, lon; char comma;
+    std::istringstream in(text);
+    if (!(in >> lat >> comma >> lon) || comma != ',') {
+        throw std::runtime_error("Expected lat,lon but got '" + text + "'");
+    }
+    return {lat, lon};
+}
+
+static std::vector<std::pair<double, double>> parseLatLonList(const std::string& text) {
+    std::vector<std::pair<double, double>> points;
+    std::istringstream in(text);
+    for (std::string item; std::getline(in, item, ';');) {
+        if (!item.empty()) points.push_back(parseLatLon(item));
+    }
+    return points;
+}
+
+static const std::string& requireParam(const HttpRequest& request, const std::string& name) {
+    auto it = request.query.find(name);
+    if (it == request.query.end()) {
+        throw std::runtime_error("Missing parameter '" + name + "'");
+    }
+    return it->second;
+}
+
+int main(int argc, char** argv){
+    uint16_t port = argc > 1 ? static_cast<uint16_t>(std::stoi(argv[1])) : 8080;
+    size_t threads = argc > 2 ? std::stoul(argv[2]) : std::thread::hardware_concurrency();
+    std::string graphPath = argc > 3 ? argv[3] : "./maps/map_graph.json";
+    size_t sptCacheMb = argc > 4 ? std::stoul(argv[4]) : 256;
+    size_t routeCacheMb = argc > 5 ? std::stoul(argv[5]) : 64;
+
+    Graph graph(graphPath);
+    const auto& G = graph.getGraph();
+    CsrGraph csr(graph);
+
+    ThreadPool pool(threads);
+    SptCache sptCache(sptCacheMb << 20);
+    RouteCache routeCache(routeCacheMb << 20);
+    std::vector<std::unique_ptr<Pathfinder>> workspaces;
+    std::vector<std::unique_ptr<DistanceTable>> tables;
+    for (size_t i = 0; i < pool.Size(); i++) {
+        workspaces.push_back(std::make_unique<Pathfinder>(graph, &sptCache));
+        tables.push_back(std::make_unique<DistanceTable>(csr));
+    }
+
+    HttpServer server(port, pool);
+
+    // Route and table searches run on per-worker Search workspaces whose
+    // arrays and queues persist between requests, so their scratch never
+    // reaches malloc. A /route cache miss still allocates what outlives the
+    // request: the shortest path tree and the path the caches keep. The
+    // /table matrix lives in the worker's QueryArena and is dropped in one
+    // go when the handler returns.
+    server.Route("/route", [&](const HttpRequest& request, size_t worker){
+        auto [lat1, lon1] = parseLatLon(requireParam(request, "from"));
+        auto [lat2, lon2] = parseLatLon(requireParam(request, "to"));
+        RouteKey key{graph.NearestNode(lat1, lon1, true), graph.NearestNode(lat2, lon2, true)};
+
+        auto route = routeCache.Get(key);
+        if (!route) {
+            Pathfinder& pathfinder = *workspaces[worker];
+            pathfinder.Search(key.start, key.end);
+
+            CachedRoute result{std::numeric_limits<double>::infinity(), {}};
+            if (pathfinder.Reachable()) {
+                result.distance = pathfinder.GetDistances()[key.end];
+                result.path = pathfinder.GetPath();
+            }
+            routeCache.Put(key, result);
+            route = std::make_shared<const CachedRoute>(std::move(result));
+        }
+
+        json out;
+        out["from"] = std::to_string(graph.IdOf(key.start));
+        out["to"] = std::to_string(graph.IdOf(key.end));
+        if (route->path.empty()) {
+            out["error"] = "No path exists";
+            return HttpResponse{404, out.dump()};
+        }
+
+        out["distance"] = route->distance;
+        json path = json::array();
+        for (uint32_t v: route->path) {
+            path.push_back({{"id", std::to_string(graph.IdOf(v))}, {"lat", G[v].lat}, {"lon", G[v].lon}});
+        }
+        out["path"] = std::move(path);
+        return HttpResponse{200, out.dump()};
+    });
+
+    server.Route("/table", [&](const HttpRequest& request, size_t worker){
+        std::vector<std::string> sources, destinations;
+        std::vector<uint32_t> sourceIndices, destinationIndices;
+        for (auto [lat, lon]: parseLatLonList(requireParam(request, "sources"))) {
+            uint32_t v = graph.NearestNode(lat, lon, true);
+            sources.push_back(std::to_string(graph.IdOf(v)));
+            sourceIndices.push_back(csr.FromGraph(v));
+        }
+        for (auto [lat, lon]: parseLatLonList(requireParam(request, "destinations"))) {
+            uint32_t v = graph.NearestNode(lat, lon, true);
+            destinations.push_back(std::to_string(graph.IdOf(v)));
+            destinationIndices.push_back(csr.FromGraph(v));
+        }
+
+        QueryArena::Scope scratch;
+        std::pmr::vector<double> matrix(sourceIndices.size() * destinationIndices.size(), scratch.Resource());
+        tables[worker]->ManyToMany(sourceIndices, destinationIndices, matrix.data());
+
+        json rows = json::array();
+        for (size_t i = 0; i < sources.size(); i++) {
+            json row = json::array();
+            for (size_t j = 0; j < destinations.size(); j++) {
+                double d = matrix[i * destinations.size() + j];
+                if (d == std::numeric_limits<double>::infinity()) row.push_back(nullptr);
+                else row.push_back(d);
+            }
+            rows.push_back(std::move(row));
+        }
+
+        json out;
+        out["sources"] = sources;
+        out["destinations"] = destinations;
+        out["distances"] = std::move(rows);
+        return HttpResponse{200, out.dump()};
+    });
+
+    server.Route("/stats", [&](const HttpRequest&, size_t){
+        json out;
+        out["route_cache"] = {{"hits", routeCache.Hits()}, {"misses", routeCache.Misses()},
+                              {"entries", routeCache.Size()}, {"bytes", routeCache.Bytes()}};
+        out["spt_cache"] = {{"hits", sptCache.Hits()}, {"misses", sptCache.Misses()},
+                            {"entries", sptCache.Size()}, {"bytes", sptCache.Bytes()}};
+        auto arena = QueryArena::Totals();
+        out["query_arena"] = {{"queries", arena.queries}, {"allocations", arena.allocations},
+                              {"bytes", arena.bytes}, {"heap_allocations", arena.upstreamAllocations},
+                              {"peak_query_bytes", arena.peakBytes}};
+        return HttpResponse{200, out.dump()};
+    });
+
+    std::cout << "Serving " << G.size() << " nodes on 127.0.0.1:" << port
+              << " with " << pool.Size() << " threads" << std::endl;
+    server.Run();
+
+    return 0;
+}
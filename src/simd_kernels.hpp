@@ -0,0 +1,254 @@
+#ifndef SIMD_KERNELS_HPP
+#define SIMD_KERNELS_HPP
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SIMD_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+// Vectorised scans over structure-of-arrays coordinates (Graph::X()/Y()).
+// Each kernel has a scalar reference version plus SSE2 and AVX2 versions on
+// x86; the widest one the CPU supports is picked once at first use. All
+// levels do the same float operations in the same order (no FMA) and break
+// ties towards the lowest index, so they agree with the scalar version.
+namespace simd {
+
+enum class Level { Scalar, Sse2, Avx2 };
+
+namespace scalar {
+    // Index of the point closest to (x, y); n must be > 0
+    inline uint32_t Nearest(const float* xs, const float* ys, uint32_t n, float x, float y) {
+        uint32_t best = 0;
+        float bestDistance = std::numeric_limits<float>::infinity();
+        for (uint32_t i = 0; i < n; i++) {
+            float dx = xs[i] - x, dy = ys[i] - y;
+            float distance = dx * dx + dy * dy;
+            if (distance < bestDistance) {
+                bestDistance = distance;
+                best = i;
+            }
+        }
+        return best;
+    }
+
+    // out[i] = scale * |p[nodes[i]] - (tx, ty)|, e.g. A* heuristics of a batch of nodes
+    inline void DistancesTo(const float* xs, const float* ys, const uint32_t* nodes, size_t count,
+                            float tx, float ty, float scale, float* out) {
+        for (size_t i = 0; i < count; i++) {
+            float dx = xs[nodes[i]] - tx, dy = ys[nodes[i]] - ty;
+            out[i] = scale * std::sqrt(dx * dx + dy * dy);
+        }
+    }
+
+    // out[i] = float((in[i] - origin) * scale), e.g. lat/lon to planar or pixel coordinates
+    inline void Affine(const double* in, size_t n, double origin, double scale, float* out) {
+        for (size_t i = 0; i < n; i++) out[i] = static_cast<float>((in[i] - origin) * scale);
+    }
+}
+
+#ifdef SIMD_KERNELS_X86
+namespace sse2 {
+    __attribute__((target("sse2")))
+    inline uint32_t Nearest(const float* xs, const float* ys, uint32_t n, float x, float y) {
+        __m128 px = _mm_set1_ps(x), py = _mm_set1_ps(y);
+        __m128 bestDistance = _mm_set1_ps(std::numeric_limits<float>::infinity());
+        __m128i bestIndex = _mm_setzero_si128(), index = _mm_setr_epi32(0, 1, 2, 3), step = _mm_set1_epi32(4);
+
+        uint32_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m128 dx = _mm_sub_ps(_mm_loadu_ps(xs + i), px), dy = _mm_sub_ps(_mm_loadu_ps(ys + i), py);
+            __m128 distance = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+            __m128 closer = _mm_cmplt_ps(distance, bestDistance);
+            bestDistance = _mm_or_ps(_mm_and_ps(closer, distance), _mm_andnot_ps(closer, bestDistance));
+            __m128i mask = _mm_castps_si128(closer);
+            bestIndex = _mm_or_si128(_mm_and_si128(mask, index), _mm_andnot_si128(mask, bestIndex));
+            index = _mm_add_epi32(index, step);
+        }
+
+        alignas(16) float distances[4];
+        alignas(16) uint32_t indices[4];
+        _mm_store_ps(distances, bestDistance);
+        _mm_store_si128(reinterpret_cast<__m128i*>(indices), bestIndex);
+
+        uint32_t best = 0;
+        float minDistance = std::numeric_limits<float>::infinity();
+        for (int lane = 0; lane < 4; lane++) {
+            if (distances[lane] < minDistance || (distances[lane] == minDistance && indices[lane] < best)) {
+                minDistance = distances[lane];
+                best = indices[lane];
+            }
+        }
+        for (; i < n; i++) {
+            float dx = xs[i] - x, dy = ys[i] - y;
+            float distance = dx * dx + dy * dy;
+            if (distance < minDistance) {
+                minDistance = distance;
+                best = i;
+            }
+        }
+        return best;
+    }
+
+    __attribute__((target("sse2")))
+    inline void DistancesTo(const float* xs, const float* ys, const uint32_t* nodes, size_t count,
+                            float tx, float ty, float scale, float* out) {
+        __m128 px = _mm_set1_ps(tx), py = _mm_set1_ps(ty), s = _mm_set1_ps(scale);
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            __m128 x = _mm_setr_ps(xs[nodes[i]], xs[nodes[i + 1]], xs[nodes[i + 2]], xs[nodes[i + 3]]);
+            __m128 y = _mm_setr_ps(ys[nodes[i]], ys[nodes[i + 1]], ys[nodes[i + 2]], ys[nodes[i + 3]]);
+            __m128 dx = _mm_sub_ps(x, px), dy = _mm_sub_ps(y, py);
+            _mm_storeu_ps(out + i, _mm_mul_ps(s, _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)))));
+        }
+        scalar::DistancesTo(xs, ys, nodes + i, count - i, tx, ty, scale, out + i);
+    }
+
+    __attribute__((target("sse2")))
+    inline void Affine(const double* in, size_t n, double origin, double scale, float* out) {
+        __m128d o = _mm_set1_pd(origin), s = _mm_set1_pd(scale);
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m128 lo = _mm_cvtpd_ps(_mm_mul_pd(_mm_sub_pd(_mm_loadu_pd(in + i), o), s));
+            __m128 hi = _mm_cvtpd_ps(_mm_mul_pd(_mm_sub_pd(_mm_loadu_pd(in + i + 2), o), s));
+            _mm_storeu_ps(out + i, _mm_movelh_ps(lo, hi));
+        }
+        scalar::Affine(in + i, n - i, origin, scale, out + i);
+    }
+}
+
+namespace avx2 {
+    __attribute__((target("avx2")))
+    inline uint32_t Nearest(const float* xs, const float* ys, uint32_t n, float x, float y) {
+        __m256 px = _mm256_set1_ps(x), py = _mm256_set1_ps(y);
+        __m256 bestDistance = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+        __m256i bestIndex = _mm256_setzero_si256(), index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        __m256i step = _mm256_set1_epi32(8);
+
+        uint32_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(xs + i), px), dy = _mm256_sub_ps(_mm256_loadu_ps(ys + i), py);
+            __m256 distance = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+            __m256 closer = _mm256_cmp_ps(distance, bestDistance, _CMP_LT_OQ);
+            bestDistance = _mm256_blendv_ps(bestDistance, distance, closer);
+            bestIndex = _mm256_blendv_epi8(bestIndex, index, _mm256_castps_si256(closer));
+            index = _mm256_add_epi32(index, step);
+        }
+
+        alignas(32) float distances[8];
+        alignas(32) uint32_t indices[8];
+        _mm256_store_ps(distances, bestDistance);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(indices), bestIndex);
+
+        uint32_t best = 0;
+        float minDistance = std::numeric_limits<float>::infinity();
+        for (int lane = 0; lane < 8; lane++) {
+            if (distances[lane] < minDistance || (distances[lane] == minDistance && indices[lane] < best)) {
+                minDistance = distances[lane];
+                best = indices[lane];
+            }
+        }
+        for (; i < n; i++) {
+            float dx = xs[i] - x, dy = ys[i] - y;
+            float distance = dx * dx + dy * dy;
+            if (distance < minDistance) {
+                minDistance = distance;
+                best = i;
+            }
+        }
+        return best;
+    }
+
+    __attribute__((target("avx2")))
+    inline void DistancesTo(const float* xs, const float* ys, const uint32_t* nodes, size_t count,
+                            float tx, float ty, float scale, float* out) {
+        __m256 px = _mm256_set1_ps(tx), py = _mm256_set1_ps(ty), s = _mm256_set1_ps(scale);
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(nodes + i));
+            __m256 dx = _mm256_sub_ps(_mm256_i32gather_ps(xs, index, 4), px);
+            __m256 dy = _mm256_sub_ps(_mm256_i32gather_ps(ys, index, 4), py);
+            __m256 squared = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+            _mm256_storeu_ps(out + i, _mm256_mul_ps(s, _mm256_sqrt_ps(squared)));
+        }
+        scalar::DistancesTo(xs, ys, nodes + i, count - i, tx, ty, scale, out + i);
+    }
+
+    __attribute__((target("avx2")))
+    inline void Affine(const double* in, size_t n, double origin, double scale, float* out) {
+        __m256d o = _mm256_set1_pd(origin), s = _mm256_set1_pd(scale);
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __m128 lo = _mm256_cvtpd_ps(_mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(in + i), o), s));
+            __m128 hi = _mm256_cvtpd_ps(_mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(in + i + 4), o), s));
+            _mm256_storeu_ps(out + i, _mm256_set_m128(hi, lo));
+        }
+        scalar::Affine(in + i, n - i, origin, scale, out + i);
+    }
+}
+#endif
+
+inline Level Supported() {
+#ifdef SIMD_KERNELS_X86
+    if (__builtin_cpu_supports("avx2")) return Level::Avx2;
+    if (__builtin_cpu_supports("sse2")) return Level::Sse2;
+#endif
+    return Level::Scalar;
+}
+
+// Level used by the dispatching functions below; can be lowered (e.g. by a
+// benchmark) but never raised past Supported()
+inline Level& ActiveLevel() {
+    static Level level = Supported();
+    return level;
+}
+
+inline const char* LevelName(Level level) {
+    switch (level) {
+        case Level::Avx2: return "avx2";
+        case Level::Sse2: return "sse2";
+        default: return "scalar";
+    }
+}
+
+inline uint32_t Nearest(const float* xs, const float* ys, uint32_t n, float x, float y) {
+#ifdef SIMD_KERNELS_X86
+    switch (ActiveLevel()) {
+        case Level::Avx2: return avx2::Nearest(xs, ys, n, x, y);
+        case Level::Sse2: return sse2::Nearest(xs, ys, n, x, y);
+        default: break;
+    }
+#endif
+    return scalar::Nearest(xs, ys, n, x, y);
+}
+
+inline void DistancesTo(const float* xs, const float* ys, const uint32_t* nodes, size_t count,
+                        float tx, float ty, float scale, float* out) {
+#ifdef SIMD_KERNELS_X86
+    switch (ActiveLevel()) {
+        case Level::Avx2: return avx2::DistancesTo(xs, ys, nodes, count, tx, ty, scale, out);
+        case Level::Sse2: return sse2::DistancesTo(xs, ys, nodes, count, tx, ty, scale, out);
+        default: break;
+    }
+#endif
+    scalar::DistancesTo(xs, ys, nodes, count, tx, ty, scale, out);
+}
+
+inline void Affine(const double* in, size_t n, double origin, double scale, float* out) {
+#ifdef SIMD_KERNELS_X86
+    switch (ActiveLevel()) {
+        case Level::Avx2: return avx2::Affine(in, n, origin, scale, out);
+        case Level::Sse2: return sse2::Affine(in, n, origin, scale, out);
+        default: break;
+    }
+#endif
+    scalar::Affine(in, n, origin, scale, out);
+}
+
+}
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef SPT_CACHE_HPP
+#define SPT_CACHE_HPP
+
+#include <cstdint>
+#include <limits>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Full shortest path tree from one source, as produced by Pathfinder.
+// Indexed by dense node index; prev is NoNode for the source and unreached nodes.
+struct ShortestPathTree {
+    static constexpr uint32_t NoNode = std::numeric_limits<uint32_t>::max();
+
+    uint32_t source = NoNode;
+    std::vector<double> dist;
+    std::vector<uint32_t> prev;
+
+    size_t Bytes() const {
+        return sizeof(ShortestPathTree) + dist.capacity() * sizeof(double) + prev.capacity() * sizeof(uint32_t);
+    }
+};
+
+// LRU cache of shortest path trees keyed by source node, bounded by an
+// approximate byte budget. Trees are immutable once inserted, so they can be
+// handed out to several threads at once; the index itself is mutex-guarded.
+class SptCache {
+    private:
+    using Entry = std::shared_ptr<const ShortestPathTree>;
+
+    std::list<Entry> m_Lru; // Most recently used at the front
+    std::unordered_map<uint32_t, std::list<Entry>::iterator> m_Index;
+    size_t m_Capacity, m_Bytes = 0;
+    uint64_t m_Hits = 0, m_Misses = 0;
+    mutable std::mutex m_Mutex;
+
+    public:
+    explicit SptCache(size_t capacityBytes)
+        : m_Capacity(capacityBytes) {}
+
+    Entry Get(uint32_t source) {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        auto it = m_Index.find(source);
+        if (it == m_Index.end()) {
+            m_Misses++;
+            return nullptr;
+        }
+        m_Hits++;
+        m_Lru.splice(m_Lru.begin(), m_Lru, it->second);
+        return *it->second;
+    }
+
+    void Put(Entry tree) {
+        size_t bytes = tree->Bytes();
+        if (bytes > m_Capacity) return;
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (auto it = m_Index.find(tree->source); it != m_Index.end()) {
+            m_Bytes -= (*it->second)->Bytes();
+            m_Lru.erase(it->second);
+            m_Index.erase(it);
+        }
+
+        m_Lru.push_front(tree);
+        m_Index[tree->source] = m_Lru.begin();
+        m_Bytes += bytes;
+
+        while (m_Bytes > m_Capacity) {
+            const Entry& oldest = m_Lru.back();
+            m_Bytes -= oldest->Bytes();
+            m_Index.erase(oldest->source);
+            m_Lru.pop_back();
+        }
+    }
+
+    inline uint64_t Hits() const { std::lock_guard<std::mutex> lock(m_Mutex); return m_Hits; }
+    inline uint64_t Misses() const { std::lock_guard<std::mutex> lock(m_Mutex); return m_Misses; }
+    inline size_t Bytes() const { std::lock_guard<std::mutex> lock(m_Mutex); return m_Bytes; }
+    inline size_t Size() const { std::lock_guard<std::mutex> lock(m_Mutex); return m_Lru.size(); }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,75 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Fixed-size pool. Tasks receive the index of the worker running them so
+// callers can keep one search workspace per thread and index it directly.
+class ThreadPool {
+    private:
+    std::vector<std::thread> m_Workers;
+    std::queue<std::function<void(size_t)>> m_Tasks;
+    std::mutex m_Mutex;
+    std::condition_variable m_Cv;
+    bool m_Stop = false;
+
+    public:
+    explicit ThreadPool(size_t threadCount) {
+        if (threadCount == 0) threadCount = 1;
+
+        for (size_t i = 0; i < threadCount; i++) {
+            m_Workers.emplace_back([this, i]{ workerLoop(i); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Stop = true;
+        }
+        m_Cv.notify_all();
+        for (auto& worker: m_Workers) worker.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    inline size_t Size() const { return m_Workers.size(); }
+
+    // Tasks submitted but not yet picked up by a worker
+    size_t Pending() {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return m_Tasks.size();
+    }
+
+    void Submit(std::function<void(size_t)> task) {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Tasks.push(std::move(task));
+        }
+        m_Cv.notify_one();
+    }
+
+    private:
+    void workerLoop(size_t index) {
+        while (true) {
+            std::function<void(size_t)> task;
+            {
+                std::unique_lock<std::mutex> lock(m_Mutex);
+                m_Cv.wait(lock, [this]{ return m_Stop || !m_Tasks.empty(); });
+                if (m_Stop && m_Tasks.empty()) return;
+
+                task = std::move(m_Tasks.front());
+                m_Tasks.pop();
+            }
+            task(index);
+        }
+    }
+};
+
+#endif
\ No newline at end of file
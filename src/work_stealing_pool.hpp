@@ -0,0 +1,144 @@
+#ifndef WORK_STEALING_POOL_HPP
+#define WORK_STEALING_POOL_HPP
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent pool for data-parallel loops. ParallelFor() splits [0, count)
+// into contiguous blocks, one per worker, cut into grain-sized chunks. A
+// worker drains its own deque from the front and, once empty, steals chunks
+// from the back of the others, so uneven per-item cost balances itself.
+class WorkStealingPool {
+    private:
+    using Range = std::pair<size_t, size_t>;
+    using Job = std::function<void(size_t index, size_t worker)>;
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Range> ranges;
+    };
+
+    std::vector<std::thread> m_Workers;
+    std::vector<std::unique_ptr<Queue>> m_Queues;
+
+    std::mutex m_Mutex;
+    std::condition_variable m_WorkCv, m_DoneCv;
+    const Job* m_Job = nullptr;
+    uint64_t m_Generation = 0;
+    size_t m_Active = 0;
+    std::exception_ptr m_Error;
+    bool m_Stop = false;
+
+    public:
+    explicit WorkStealingPool(size_t threadCount) {
+        if (threadCount == 0) threadCount = 1;
+
+        for (size_t i = 0; i < threadCount; i++) {
+            m_Queues.push_back(std::make_unique<Queue>());
+        }
+        for (size_t i = 0; i < threadCount; i++) {
+            m_Workers.emplace_back([this, i]{ workerLoop(i); });
+        }
+    }
+
+    ~WorkStealingPool() {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Stop = true;
+        }
+        m_WorkCv.notify_all();
+        for (auto& worker: m_Workers) worker.join();
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    inline size_t Size() const { return m_Workers.size(); }
+
+    // Blocks until fn(i, worker) has run for every i; rethrows the first error
+    void ParallelFor(size_t count, size_t grain, const Job& fn) {
+        if (count == 0) return;
+        if (grain == 0) grain = 1;
+
+        size_t workers = m_Workers.size();
+        for (size_t w = 0; w < workers; w++) {
+            size_t begin = count * w / workers, end = count * (w + 1) / workers;
+            std::lock_guard<std::mutex> lock(m_Queues[w]->mutex);
+            for (size_t b = begin; b < end; b += grain) {
+                m_Queues[w]->ranges.emplace_back(b, std::min(b + grain, end));
+            }
+        }
+
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_Job = &fn;
+        m_Error = nullptr;
+        m_Active = workers;
+        m_Generation++;
+        m_WorkCv.notify_all();
+
+        m_DoneCv.wait(lock, [this]{ return m_Active == 0; });
+        m_Job = nullptr;
+        if (m_Error) std::rethrow_exception(m_Error);
+    }
+
+    private:
+    bool popLocal(size_t worker, Range& range) {
+        Queue& queue = *m_Queues[worker];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.ranges.empty()) return false;
+        range = queue.ranges.front();
+        queue.ranges.pop_front();
+        return true;
+    }
+
+    bool steal(size_t thief, Range& range) {
+        size_t workers = m_Queues.size();
+        for (size_t k = 1; k < workers; k++) {
+            Queue& victim = *m_Queues[(thief + k) % workers];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (victim.ranges.empty()) continue;
+            range = victim.ranges.back();
+            victim.ranges.pop_back();
+            return true;
+        }
+        return false;
+    }
+
+    void workerLoop(size_t worker) {
+        uint64_t seen = 0;
+        while (true) {
+            const Job* job;
+            {
+                std::unique_lock<std::mutex> lock(m_Mutex);
+                m_WorkCv.wait(lock, [&]{ return m_Stop || m_Generation != seen; });
+                if (m_Stop) return;
+                seen = m_Generation;
+                job = m_Job;
+            }
+
+            // No chunks are added mid-job, so empty deques everywhere means done
+            Range range;
+            while (popLocal(worker, range) || steal(worker, range)) {
+                try {
+                    for (size_t i = range.first; i < range.second; i++) (*job)(i, worker);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(m_Mutex);
+                    if (!m_Error) m_Error = std::current_exception();
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if (--m_Active == 0) m_DoneCv.notify_one();
+        }
+    }
+};
+
+#endif
\ No newline at end of file